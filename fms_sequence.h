@@ -1,12 +1,63 @@
 // fms_sequence.h - forward iterators that can be dereferenced when operator bool() const is true
 #pragma once
 #include <array>
+#include <algorithm>
 #include <functional>
-#include <typeinfo>
+#include <limits>
+#include <tuple>
 #include <type_traits>
+#include <utility>
+#include "fms_sequence_simd.h"
 
 namespace fms::sequence {
 
+    // size() of sequences that never terminate
+    constexpr size_t infinite = std::numeric_limits<size_t>::max();
+
+    // value_type, operator bool, operator* and operator++
+    template<class S, class = void>
+    struct is_sequence : std::false_type { };
+    template<class S>
+    struct is_sequence<S, std::void_t<typename S::value_type,
+        decltype(static_cast<bool>(std::declval<const S&>())),
+        decltype(*std::declval<const S&>()),
+        decltype(++std::declval<S&>())>> : std::true_type { };
+    template<class S>
+    constexpr bool is_sequence_v = is_sequence<S>::value;
+
+    // sequences having size_t size() const report the number of remaining elements in O(1)
+    template<class S, class = void>
+    struct is_sized : std::false_type { };
+    template<class S>
+    struct is_sized<S, std::void_t<decltype(std::declval<const S&>().size())>> : std::true_type { };
+    template<class S>
+    constexpr bool is_sized_v = is_sized<S>::value;
+
+    // sequences having advance(size_t n) skip n elements in O(1)
+    template<class S, class = void>
+    struct is_advanceable : std::false_type { };
+    template<class S>
+    struct is_advanceable<S, std::void_t<decltype(std::declval<S&>().advance(size_t{}))>> : std::true_type { };
+    template<class S>
+    constexpr bool is_advanceable_v = is_advanceable<S>::value;
+
+    // fuses known shapes of operator+ - * / into cheaper sequences
+    struct rewrite;
+
+    // sequences having fill(value_type* t, size_t n) generate the next n elements in a batch
+    template<class S, class = void>
+    struct is_fillable : std::false_type { };
+    template<class S>
+    struct is_fillable<S, std::void_t<decltype(std::declval<S&>().fill(std::declval<typename S::value_type*>(), size_t{}))>> : std::true_type { };
+    template<class S>
+    constexpr bool is_fillable_v = is_fillable<S>::value;
+
+    // a + b without overflowing infinite
+    inline constexpr size_t size_add(size_t a, size_t b) noexcept
+    {
+        return a > infinite - b ? infinite : a + b;
+    }
+
     // unsafe sequence
     template <class T>
     class pointer {
@@ -30,12 +81,26 @@ namespace fms::sequence {
         {
             return true;
         }
+        size_t size() const noexcept
+        {
+            return infinite;
+        }
+        T* data() const noexcept
+        {
+            return t;
+        }
         pointer& operator++()
         {
             ++t;
 
             return *this;
         }
+        pointer& advance(size_t n) noexcept
+        {
+            t += n;
+
+            return *this;
+        }
         value_type operator*() const
         {
             return *t;
@@ -55,6 +120,10 @@ namespace fms::sequence {
         {
             return n;
         }
+        const S& base() const noexcept
+        {
+            return s;
+        }
         // same sequence and size
         bool operator==(const take& s) const
         {
@@ -77,6 +146,16 @@ namespace fms::sequence {
 
             return *this;
         }
+        // skip min(m, size()) elements
+        template<class S_ = S, class = std::enable_if_t<is_advanceable_v<S_>>>
+        take& advance(size_t m)
+        {
+            m = (std::min)(m, n);
+            n -= m;
+            s.advance(m);
+
+            return *this;
+        }
         value_type operator*() const
         {
             return *s;
@@ -99,10 +178,18 @@ namespace fms::sequence {
         return take(N, pointer<T>(&t[0]));
     }
 
+    // take<pointer<T>>
+    template<class S>
+    struct is_pointer_array : std::false_type { };
+    template<class T>
+    struct is_pointer_array<take<pointer<T>>> : std::true_type { };
+    template<class S>
+    constexpr bool is_pointer_array_v = is_pointer_array<S>::value;
+
     template <class T = double>
     class constant {
         T t;
-
+        friend struct rewrite;
     public:
         typedef T value_type;
         constant(T t = 0) noexcept
@@ -121,6 +208,10 @@ namespace fms::sequence {
         {
             return true;
         }
+        size_t size() const noexcept
+        {
+            return infinite;
+        }
         constant& operator++()
         {
             return *this;
@@ -154,6 +245,10 @@ namespace fms::sequence {
         {
             return *s + 1 != 1;
         }
+        const S& base() const noexcept
+        {
+            return s;
+        }
         epsilon& operator++()
         {
             if (*this) {
@@ -171,6 +266,7 @@ namespace fms::sequence {
     template<class T = double>
     class factorial {
         T n_, n;
+        friend struct rewrite;
     public:
         typedef T value_type;
         factorial() noexcept
@@ -188,6 +284,10 @@ namespace fms::sequence {
         {
             return true;
         }
+        size_t size() const noexcept
+        {
+            return infinite;
+        }
         factorial& operator++()
         {
             n_ *= ++n;
@@ -205,25 +305,27 @@ namespace fms::sequence {
     class generate {
         T t0, dt;
         Op op;
+        friend struct rewrite;
     public:
         typedef T value_type;
-        generate(T t0, T dt = 1) noexcept
+        constexpr generate(T t0, T dt = 1) noexcept
             : t0(t0), dt(dt), op(Op{})
         {
         }
-        bool operator==(const generate& s)
+        bool operator==(const generate& s) const
         {
-            return t0 == s.t0 && dt == s.dt && typeid(op) == typeid(s.op);
+            return t0 == s.t0 && dt == s.dt;
         }
         bool operator!=(const generate& s) const { return !operator==(s); }
-        operator bool() const { return false; }
-        generate& operator++()
+        constexpr operator bool() const { return true; }
+        size_t size() const noexcept { return infinite; }
+        constexpr generate& operator++()
         {
             t0 = op(t0, dt);
 
             return *this;
         }
-        value_type operator*() const { return t0; }
+        constexpr value_type operator*() const { return t0; }
     };
     template<class T>
     using linear = generate<T, std::plus<T>>;
@@ -252,6 +354,10 @@ namespace fms::sequence {
         {
             return *t != 0;
         }
+        T* data() const noexcept
+        {
+            return t;
+        }
         null& operator++()
         {
             if (*this) {
@@ -266,11 +372,87 @@ namespace fms::sequence {
         }
     };
 
+    // elements of s while p(*s) is true
+    template<class P, class S>
+    class take_while {
+        P p;
+        S s;
+    public:
+        typedef typename S::value_type value_type;
+        take_while(P p, S s)
+            : p(p), s(s)
+        { }
+        bool operator==(const take_while& s) const
+        {
+            return this->s == s.s;
+        }
+        bool operator!=(const take_while& s) const
+        {
+            return !operator==(s);
+        }
+        operator bool() const
+        {
+            return s && p(*s);
+        }
+        const P& predicate() const noexcept
+        {
+            return p;
+        }
+        const S& base() const noexcept
+        {
+            return s;
+        }
+        take_while& operator++()
+        {
+            if (*this) {
+                ++s;
+            }
+
+            return *this;
+        }
+        value_type operator*() const
+        {
+            return *s;
+        }
+    };
+
+    // terminated sequences over contiguous memory viewed as arrays
+    // null and epsilon terminators are found by SSE2 scans where available,
+    // take_while by a blocked scan of its predicate
+    template<class T>
+    inline auto array(null<T> s)
+    {
+        return array(simd::find_zero(s.data()), s.data());
+    }
+    template<class T>
+    inline auto array(epsilon<take<pointer<T>>> s)
+    {
+        auto a = s.base();
+
+        return array(simd::find_negligible(a.base().data(), a.size()), a.base().data());
+    }
+    template<class P, class T>
+    inline auto array(take_while<P, take<pointer<T>>> s)
+    {
+        auto a = s.base();
+
+        return array(simd::find_if_not(a.base().data(), a.size(), s.predicate()), a.base().data());
+    }
+
+    // sequences having an array(s) view
+    template<class S, class = void>
+    struct is_contiguous : std::false_type { };
+    template<class S>
+    struct is_contiguous<S, std::void_t<decltype(array(std::declval<S>()))>> : std::true_type { };
+    template<class S>
+    constexpr bool is_contiguous_v = is_contiguous<S>::value;
+
     // 1 = t^0, t = t^1, t^2, ...
     template<class T = double>
     class power {
         T t;
         T tn; // t^n
+        friend struct rewrite;
     public:
         typedef T value_type;
         power(T t) noexcept
@@ -288,6 +470,10 @@ namespace fms::sequence {
         {
             return true;
         }
+        size_t size() const noexcept
+        {
+            return infinite;
+        }
         power& operator++()
         {
             tn *= t;
@@ -313,7 +499,7 @@ namespace fms::sequence {
         { }
         bool operator==(const binop& s) const
         {
-            return  typeid(op) == typeid(s.op) && s0 == s.s0 && s1 == s.s1;
+            return s0 == s.s0 && s1 == s.s1;
         }
         bool operator!=(const binop& s) const
         {
@@ -323,6 +509,13 @@ namespace fms::sequence {
         {
             return s0 && s1;
         }
+        // sized if both sequences are sized
+        template<class S0_ = S0, class S1_ = S1,
+            class = std::enable_if_t<is_sized_v<S0_> && is_sized_v<S1_>>>
+        size_t size() const noexcept
+        {
+            return (std::min)(s0.size(), s1.size());
+        }
         binop& operator++()
         {
             ++s0;
@@ -336,18 +529,46 @@ namespace fms::sequence {
         }
     };
     
+    // f(std::get<i>(t)) for a run time index i, a fold over the indices
+    // instead of recursion so there is one instantiation for any tuple size
+    template<class Tuple, class F, size_t... I>
+    inline void apply_at(Tuple& t, size_t i, F f, std::index_sequence<I...>)
+    {
+        ((i == I ? (void)f(std::get<I>(t)) : (void)0), ...);
+    }
+    template<class Tuple, class F>
+    inline void apply_at(Tuple& t, size_t i, F f)
+    {
+        apply_at(t, i, f, std::make_index_sequence<std::tuple_size_v<std::remove_const_t<Tuple>>>{});
+    }
+
+    // total size of a tuple of sized sequences, not viable unless all are sized
+    template<class... S, class = std::enable_if_t<(is_sized_v<S> && ...)>>
+    inline size_t size_sum(const std::tuple<S...>& t) noexcept
+    {
+        return std::apply([](const S& ...ss) {
+            size_t n = 0;
+            ((n = size_add(n, ss.size())), ...);
+            return n;
+        }, t);
+    }
+
+    // s0 followed by s1 followed by ...
     template<class ...S>
     class concatenate {
+        static constexpr size_t N = sizeof...(S);
         std::tuple<S...> s;
         size_t i; // active index
     public:
         typedef std::common_type_t<typename S::value_type...> value_type;
         concatenate(S ...ss) noexcept
-            : s(ss...)
-        { }
+            : s(ss...), i(0)
+        {
+            next();
+        }
         bool operator==(const concatenate& s) const
         {
-            return  this->s == s.s;
+            return  i == s.i && this->s == s.s;
         }
         bool operator!=(const concatenate& s) const
         {
@@ -355,101 +576,165 @@ namespace fms::sequence {
         }
         operator bool() const
         {
-            return i != std::tuple_size_v<std::tuple<S...>>;
+            return i != N;
+        }
+        // sized if all sequences are sized
+        template<class T = std::tuple<S...>>
+        auto size() const noexcept -> decltype(size_sum(std::declval<const T&>()))
+        {
+            return size_sum(s);
         }
         concatenate& operator++()
         {
-            /*
             if (*this) {
-                auto& si = get(i);
-                if (si) {
-                    ++si;
-                }
-                else {
-                    ++i;
-                }
-            }*/
+                increment();
+                next();
+            }
 
             return *this;
         }
         value_type operator*() const
         {
-            return *get(i);
+            return star();
         }
     private:
-        auto get(size_t i)
-        {
-            switch (i) {
-            case 0:
-                return std::get<0>(s);
-                break;
-  /*          case 1:
-                return std::get<1>(s);
-                break;
-            case 2:
-                return std::get<2>(s);
-                break;
-            case 3:
-                return std::get<3>(s);
-                break;
-            case 4:
-                return std::get<4>(s);
-                break;
-            case 5:
-                return std::get<5>(s);
-                break;
-            case 6:
-                return std::get<6>(s);
-                break;
-            case 7:
-                return std::get<7>(s);
-                break;
-            case 8:
-                return std::get<8>(s);
-                break;
-            case 9:
-                return std::get<9>(s);
-                break;
-*/            }
-
-            throw std::runtime_error("concatenate::get index out of range");
-        }
-        auto get(size_t i) const
-        {
-            switch (i) {
-            case 0:
-                return std::get<0>(s);
-                break;
-/*            case 1:
-                return std::get<1>(s);
-                break;
-            case 2:
-                return std::get<2>(s);
-                break;
-            case 3:
-                return std::get<3>(s);
-                break;
-            case 4:
-                return std::get<4>(s);
-                break;
-            case 5:
-                return std::get<5>(s);
-                break;
-            case 6:
-                return std::get<6>(s);
-                break;
-            case 7:
-                return std::get<7>(s);
-                break;
-            case 8:
-                return std::get<8>(s);
-                break;
-            case 9:
-                return std::get<9>(s);
-                break;
-  */          }
-
-            throw std::runtime_error("concatenate::get index out of range");
+        void increment()
+        {
+            apply_at(s, i, [](auto& si) { ++si; });
+        }
+        // advance active index past exhausted sequences
+        void next()
+        {
+            next(std::make_index_sequence<N>{});
+        }
+        template<size_t... I>
+        void next(std::index_sequence<I...>)
+        {
+            ((i == I && !std::get<I>(s) ? (void)++i : (void)0), ...);
+        }
+        value_type star() const
+        {
+            value_type t{};
+            apply_at(s, i, [&t](const auto& si) { t = *si; });
+
+            return t;
+        }
+    };
+
+    // t, t x/(k+1), t x^2/((k+1)(k+2)), ...
+    // x^n/n! by recurrence, no overflow of x^n or n! and no division by n!
+    template<class T = double>
+    class power_factorial {
+        T x, t;
+        T k; // index of the factorial in the denominator
+    public:
+        typedef T value_type;
+        constexpr power_factorial(T x, T t = 1, T k = 0) noexcept
+            : x(x), t(t), k(k)
+        { }
+        bool operator==(const power_factorial& s) const
+        {
+            return x == s.x && t == s.t && k == s.k;
+        }
+        bool operator!=(const power_factorial& s) const
+        {
+            return !operator==(s);
+        }
+        constexpr operator bool() const
+        {
+            return true;
+        }
+        size_t size() const noexcept
+        {
+            return infinite;
+        }
+        constexpr power_factorial& operator++()
+        {
+            k += 1;
+            t = t * x / k;
+
+            return *this;
+        }
+        constexpr value_type operator*() const
+        {
+            return t;
+        }
+    };
+
+    // c * s[0], c * s[1], ...
+    template<class S, class T = typename S::value_type>
+    class scale {
+        T c;
+        S s;
+    public:
+        typedef T value_type;
+        scale(T c, S s) noexcept
+            : c(c), s(s)
+        { }
+        bool operator==(const scale& s) const
+        {
+            return c == s.c && this->s == s.s;
+        }
+        bool operator!=(const scale& s) const
+        {
+            return !operator==(s);
+        }
+        operator bool() const
+        {
+            return static_cast<bool>(s);
+        }
+        template<class S_ = S, class = std::enable_if_t<is_sized_v<S_>>>
+        size_t size() const noexcept
+        {
+            return s.size();
+        }
+        scale& operator++()
+        {
+            ++s;
+
+            return *this;
+        }
+        value_type operator*() const
+        {
+            return c * *s;
+        }
+    };
+
+    struct rewrite {
+        // c op d is constant
+        template<class Op, class T, class U>
+        static auto fold(Op op, const constant<T>& c, const constant<U>& d)
+        {
+            return constant(op(c.t, d.t));
+        }
+        template<class T, class U, class V = std::common_type_t<T, U>>
+        static auto divide(const power<T>& p, const factorial<U>& f)
+        {
+            return power_factorial<V>(p.t, V(p.tn) / V(f.n_), f.n);
+        }
+        // c x^0/k!, c x^1/(k+1)!, ... with x = 1
+        template<class T, class U, class V = std::common_type_t<T, U>>
+        static auto divide(const constant<T>& c, const factorial<U>& f)
+        {
+            return power_factorial<V>(1, V(c.t) / V(f.n_), f.n);
+        }
+        template<class T, class U, class V = std::common_type_t<T, U>>
+        static auto multiply(const generate<T, std::multiplies<T>>& g, const generate<U, std::multiplies<U>>& h)
+        {
+            return generate<V, std::multiplies<V>>(V(g.t0) * V(h.t0), V(g.dt) * V(h.dt));
+        }
+        template<class T, class U, class V = std::common_type_t<T, U>>
+        static auto multiply(const power<T>& p, const power<U>& q)
+        {
+            power<V> pq(V(p.t) * V(q.t));
+            pq.tn = V(p.tn) * V(q.tn);
+
+            return pq;
+        }
+        template<class T, class S, class V = std::common_type_t<T, typename S::value_type>>
+        static auto multiply(const constant<T>& c, const S& s)
+        {
+            return scale<S, V>(c.t, s);
         }
     };
 
@@ -457,82 +742,198 @@ namespace fms::sequence {
     // Functions
     //
 
-    template<class S0, class S1>
+    template<class S0, class S1, class = std::enable_if_t<is_sequence_v<S0> && is_sequence_v<S1>>>
     inline auto operator+(S0 s0, S1 s1)
     {
         return binop(std::plus<std::common_type_t<typename S0::value_type, typename S1::value_type>>{}, s0, s1);
     }
-    template<class S0, class S1>
+    template<class S0, class S1, class = std::enable_if_t<is_sequence_v<S0> && is_sequence_v<S1>>>
     inline auto operator-(S0 s0, S1 s1)
     {
         return binop(std::minus<std::common_type_t<typename S0::value_type, typename S1::value_type>>{}, s0, s1);
     }
-    template<class S0, class S1>
+    template<class S0, class S1, class = std::enable_if_t<is_sequence_v<S0> && is_sequence_v<S1>>>
     inline auto operator*(S0 s0, S1 s1)
     {
         return binop(std::multiplies<std::common_type_t<typename S0::value_type, typename S1::value_type>>{}, s0, s1);
     }
-    template<class S0, class S1>
+    template<class S0, class S1, class = std::enable_if_t<is_sequence_v<S0> && is_sequence_v<S1>>>
     inline auto operator/(S0 s0, S1 s1)
     {
         return binop(std::divides<std::common_type_t<typename S0::value_type, typename S1::value_type>>{}, s0, s1);
     }
 
-    // s[0] + x*(s[1] + x*(...))
-    template<class S, class T = S::value_type>
-    inline T horner(S s, T x)
+    // rewrites more specialized than the generic operators above
+
+    template<class T, class U>
+    inline auto operator+(constant<T> c, constant<U> d)
+    {
+        return rewrite::fold(std::plus<std::common_type_t<T, U>>{}, c, d);
+    }
+    template<class T, class U>
+    inline auto operator-(constant<T> c, constant<U> d)
+    {
+        return rewrite::fold(std::minus<std::common_type_t<T, U>>{}, c, d);
+    }
+    template<class T, class U>
+    inline auto operator*(constant<T> c, constant<U> d)
+    {
+        return rewrite::fold(std::multiplies<std::common_type_t<T, U>>{}, c, d);
+    }
+    template<class T, class U>
+    inline auto operator/(constant<T> c, constant<U> d)
     {
-        return !s ? 0 : *s + x * horner(++s, x);
+        return rewrite::fold(std::divides<std::common_type_t<T, U>>{}, c, d);
     }
 
-    template <class S>
-    inline S last(S s)
+    template<class T, class S, class = std::enable_if_t<is_sequence_v<S>>>
+    inline auto operator*(constant<T> c, S s)
+    {
+        return rewrite::multiply(c, s);
+    }
+    template<class S, class T, class = std::enable_if_t<is_sequence_v<S>>>
+    inline auto operator*(S s, constant<T> c)
     {
-        S s_ = s;
+        return rewrite::multiply(c, s);
+    }
 
-        while (*++s) {
-            ++s_;
+    template<class T, class U>
+    inline auto operator*(generate<T, std::multiplies<T>> g, generate<U, std::multiplies<U>> h)
+    {
+        return rewrite::multiply(g, h);
+    }
+    template<class T, class U>
+    inline auto operator*(power<T> p, power<U> q)
+    {
+        return rewrite::multiply(p, q);
+    }
+
+    // integer division does not factor so only rewrite non integral types
+    template<class T, class U, class = std::enable_if_t<!std::is_integral_v<std::common_type_t<T, U>>>>
+    inline auto operator/(power<T> p, factorial<U> f)
+    {
+        return rewrite::divide(p, f);
+    }
+    template<class T, class U, class = std::enable_if_t<!std::is_integral_v<std::common_type_t<T, U>>>>
+    inline auto operator/(constant<T> c, factorial<U> f)
+    {
+        return rewrite::divide(c, f);
+    }
+
+    // s[0] + x*(s[1] + x*(...)) for finite s, evaluated from the last term back
+    template<class S, class T = typename S::value_type>
+    inline T horner(S s, T x)
+    {
+        T y = 0;
+
+        if constexpr (is_pointer_array_v<S>) {
+            const auto* t = s.base().data();
+            for (size_t i = s.size(); i-- > 0; ) {
+                T ti = t[i];
+                y = ti + x * y;
+            }
+        }
+        else if constexpr (is_contiguous_v<S>) {
+            y = horner(array(s), x);
         }
+        else {
+            // blocks of terms on the stack, recursing once per block
+            constexpr size_t B = 64;
+            T t[B];
+            size_t n = 0;
 
-        return s_;
+            for (; s && n < B; ++s) {
+                t[n++] = *s;
+            }
+            if (s) {
+                y = horner(s, x);
+            }
+            while (n-- > 0) {
+                y = t[n] + x * y;
+            }
+        }
+
+        return y;
     }
+
+    // remaining number of elements, O(1) for sized sequences
     template <class S>
-    inline auto back(S s)
+    inline size_t length(S s)
     {
-        return *last(s);
+        if constexpr (is_contiguous_v<S>) {
+            return array(s).size();
+        }
+        else if constexpr (is_sized_v<S>) {
+            return s.size();
+        }
+        else {
+            size_t n = 0;
+
+            while (s) {
+                ++n;
+                ++s;
+            }
+
+            return n;
+        }
     }
 
     template <class S>
     inline S drop(size_t n, S s)
     {
-        while (s && n--)
-            ++s;
+        if constexpr (is_advanceable_v<S>) {
+            s.advance(n);
+        }
+        else if constexpr (is_sized_v<S>) {
+            n = (std::min)(n, s.size());
+            while (n--)
+                ++s;
+        }
+        else {
+            while (s && n--)
+                ++s;
+        }
 
         return s;
     }
 
+    // sequence at the last element
     template <class S>
-    inline size_t length(S s)
+    inline S last(S s)
     {
-        size_t n = 0;
+        if constexpr (is_sized_v<S>) {
+            size_t n = s.size();
 
-        while (s) {
-            ++n;
-            ++s;
+            return n ? drop(n - 1, s) : s;
         }
+        else {
+            if (!s)
+                return s;
+
+            S s_ = s;
 
-        return n;
+            while (++s) {
+                ++s_;
+            }
+
+            return s_;
+        }
     }
     template <class S>
-    inline size_t length(take<S> s)
+    inline auto back(S s)
     {
-        return s.size();
+        return *last(s);
     }
 
     // same values and length
     template <class U, class V>
     inline bool same(U u, V v)
     {
+        if constexpr (is_sized_v<U> && is_sized_v<V>) {
+            if (u.size() != v.size())
+                return false;
+        }
+
         while (u && v) {
             if (*u != *v)
                 return false;
@@ -546,31 +947,59 @@ namespace fms::sequence {
     template <class S>
     inline typename S::value_type sum(S s)
     {
-        if (!s)
-            return 0;
+        if constexpr (is_contiguous_v<S>) {
+            return sum(array(s));
+        }
+        else {
+            if (!s)
+                return 0;
 
-        typename S::value_type t = *s;
+            typename S::value_type t = *s;
 
-        while (++s) {
-            t += *s;
-        }
+            if constexpr (is_sized_v<S>) {
+                // no termination test per element
+                for (size_t n = s.size(); --n; ) {
+                    ++s;
+                    t += *s;
+                }
+            }
+            else {
+                while (++s) {
+                    t += *s;
+                }
+            }
 
-        return t;
+            return t;
+        }
     }
 
     template <class S>
     inline typename S::value_type product(S s)
     {
-        if (!s)
-            return 1;
+        if constexpr (is_contiguous_v<S>) {
+            return product(array(s));
+        }
+        else {
+            if (!s)
+                return 1;
 
-        typename S::value_type t = *s;
+            typename S::value_type t = *s;
 
-        while (++s) {
-            t *= *s;
-        }
+            if constexpr (is_sized_v<S>) {
+                // no termination test per element
+                for (size_t n = s.size(); --n; ) {
+                    ++s;
+                    t *= *s;
+                }
+            }
+            else {
+                while (++s) {
+                    t *= *s;
+                }
+            }
 
-        return t;
+            return t;
+        }
     }
 
 } // namespace fms::sequence
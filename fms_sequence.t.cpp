@@ -1,14 +1,27 @@
 // fms_sequence.t.cpp - test sequences
 #include <cassert>
+#include <cfloat>
 #include <cmath>
 #include <chrono>
+#include <cstdlib>
 #include "fms_sequence.h"
+#include "fms_sequence_arena.h"
+#include "fms_sequence_random.h"
+#include "fms_sequence_dual.h"
+#include "fms_sequence_reduce.h"
+#include "fms_sequence_rolling.h"
+#include "fms_sequence_merge.h"
+#include "fms_sequence_compress.h"
+#include "fms_sequence_recurrence.h"
+#include "fms_sequence_continued_fraction.h"
+#include "fms_sequence_elementary.h"
+#include "fms_sequence_perf.h"
 
 using namespace fms;
 
 inline auto time(const std::function<void(void)>& f, size_t n = 1)
 {
-    std::chrono::time_point<std::chrono::steady_clock> tp;
+    std::chrono::time_point<std::chrono::high_resolution_clock> tp;
 
     tp = std::chrono::high_resolution_clock::now();
     while (n--)
@@ -18,6 +31,18 @@ inline auto time(const std::function<void(void)>& f, size_t n = 1)
     return duration;
 }
 
+// per element time and hardware counters, printed if FMS_SEQUENCE_BENCH is set
+inline auto bench(const char* label, const std::function<void(void)>& f, size_t n, size_t repeat = 1)
+{
+    auto s = sequence::perf::measure(f, n, repeat);
+
+    if (std::getenv("FMS_SEQUENCE_BENCH")) {
+        sequence::perf::print(stdout, label, s);
+    }
+
+    return s;
+}
+
 template<class T>
 void test_array()
 {
@@ -102,6 +127,51 @@ void test_null()
     assert(!s);
 }
 
+template<class T>
+void test_scan()
+{
+    // every start and terminator position across block boundaries
+    T t[64];
+    for (size_t n = 0; n < 40; ++n) {
+        for (size_t i = 0; i < 64; ++i) {
+            t[i] = static_cast<T>(1 + i % 7);
+        }
+        for (size_t off = 0; off < 17; ++off) {
+            t[off + n] = 0;
+            sequence::null<T> s(t + off);
+            assert(n == length(s));
+            T u = 0;
+            for (size_t i = 0; i < n; ++i) {
+                u += t[off + i];
+            }
+            assert(u == sum(s));
+            t[off + n] = static_cast<T>(1 + (off + n) % 7);
+        }
+    }
+    {
+        T u[] = { 1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,16,17,18,19,20 };
+        auto s = sequence::take_while([](T x) { return x < 18; }, sequence::array(u));
+        assert(17 == length(s));
+        assert(static_cast<T>(17 * 18 / 2) == sum(s));
+        assert(sequence::same(s, sequence::array(17, u)));
+        auto s2 = sequence::take_while([](T x) { return x < 100; }, sequence::array(u));
+        assert(20 == length(s2));
+    }
+    if constexpr (std::is_floating_point_v<T>) {
+        // epsilon terminator at every position, and none
+        T u[40];
+        for (size_t n = 0; n <= 40; ++n) {
+            for (size_t i = 0; i < 40; ++i) {
+                u[i] = static_cast<T>(i == n ? 1e-20 : 1 + i);
+            }
+            auto e = sequence::epsilon(sequence::array(u));
+            assert(n == sequence::simd::find_negligible(u, 40));
+            assert(n == sequence::array(e).size());
+            assert(n == length(e));
+        }
+    }
+}
+
 void test_constant()
 {
     sequence::constant<int> five(5);
@@ -136,6 +206,16 @@ void test_drop()
         assert(!s1);
         assert(0 == length(drop(10, s)));
     }
+    {
+        // arrays skip in O(1)
+        static_assert(sequence::is_advanceable_v<decltype(s)>);
+        static_assert(!sequence::is_advanceable_v<decltype(sequence::take(3, sequence::constant(1)))>);
+        assert(*drop(2, s) == 3);
+        assert(drop(3, s).size() == 0);
+        assert(drop(10, s).base().data() == t + 3);
+        assert(*last(s) == 3);
+        assert(back(s) == 3);
+    }
 }
 
 void test_iota()
@@ -221,6 +301,13 @@ void test_length()
     {
         assert(53 == length(sequence::epsilon(sequence::geometric<double>(1., .5))));
     }
+    {
+        double t[] = { 1, 1e-10, 1e-17, 1 };
+        auto se = sequence::epsilon(sequence::array(t));
+        assert(2 == length(se));
+        assert(1 + 1e-10 == sum(se));
+        assert(2 == length(sequence::epsilon(sequence::array(2, t))));
+    }
     {
         int t[] = { 1,2,3 };
         assert(3 == length(sequence::array(t)));
@@ -379,6 +466,13 @@ void test_binop()
         assert(exp(x) - sum(s) == -2 * std::numeric_limits<double>::epsilon());
         assert(exp(x) == horner(epsilon(constant(1) / factorial<>()), x));
 
+        // arrays are evaluated in place, long sequences spill past the stack buffer
+        double c[] = { 1, 2, 3 };
+        assert(1 + 2 * 3. + 3 * 9. == horner(sequence::array(c), 3.));
+        assert(0 == horner(sequence::take(0, constant(1.)), 3.));
+        assert(100 == horner(sequence::take(100, constant(1.)), 1.));
+        assert(std::fabs(horner(sequence::take(100, constant(1.)), .5) - 2) < 1e-15);
+
         auto duration = time([s]() { return sum(s); }, 10000);
         duration = duration;
         duration = time([x]() { return horner(epsilon(constant(1) / factorial<>()), x); }, 10000);
@@ -406,7 +500,901 @@ void test_concatenate()
         ++c;
         assert(c);
         assert(*c == 2);
+        ++c;
+        assert(c);
+        assert(*c == 3);
+        assert(3 == length(c));
+        assert(5 == back(c));
+        ++c;
+        ++c;
+        ++c;
+        assert(!c);
+    }
+    {
+        using sequence::concatenate;
+        using sequence::array;
+        using sequence::take;
+        using sequence::pointer;
+
+        T a[] = { 1,2 };
+        T b[] = { 3,4,5 };
+        auto c = concatenate(take(0, pointer(a)), array(a), take(0, pointer(b)), array(b));
+        assert(5 == length(c));
+        T d[] = { 1,2,3,4,5 };
+        assert(sequence::same(c, array(d)));
+        assert(!sequence::same(c, array(4, d)));
+    }
+}
+
+void test_size()
+{
+    using sequence::is_sized_v;
+    using sequence::array;
+    using sequence::epsilon;
+    using sequence::power;
+    using sequence::null;
+
+    int t[] = { 1,2,3 };
+    auto a = array(t);
+    static_assert(is_sized_v<decltype(a)>);
+    static_assert(is_sized_v<power<>>);
+    static_assert(!is_sized_v<epsilon<power<>>>);
+    static_assert(!is_sized_v<null<int>>);
+    static_assert(is_sized_v<decltype(a + power<int>(2))>);
+    static_assert(!is_sized_v<decltype(a + null<int>(t))>);
+    static_assert(is_sized_v<decltype(sequence::concatenate(a, a))>);
+    static_assert(!is_sized_v<decltype(sequence::concatenate(a, null<int>(t)))>);
+    static_assert(is_sized_v<decltype(sequence::merge(std::less<int>{}, a, a))>);
+    static_assert(!is_sized_v<decltype(sequence::merge(std::less<int>{}, a, null<int>(t)))>);
+
+    assert(3 == length(a + power<int>(2)));
+    assert(sequence::infinite == length(power<int>(2)));
+    assert(2 == length(drop(1, a + power<int>(2))));
+    assert(6 == length(sequence::concatenate(a, a)));
+    assert(sequence::infinite == length(sequence::concatenate(a, power<int>(2))));
+
+    assert(3 == back(a));
+    assert(3 * 4 == back(a * power<int>(2)));
+    assert(!last(drop(3, a)));
+
+    int z[] = { 1,2,3,0 };
+    assert(3 == back(null<int>(z)));
+    assert(!last(null<int>(z + 3)));
+}
+
+void test_materialize()
+{
+    using sequence::arena;
+    using sequence::materialize;
+
+    {
+        arena a(64);
+        int t[] = { 1,2,3 };
+        auto s = materialize(sequence::array(t), a);
+        static_assert(std::is_same_v<decltype(s), sequence::take<sequence::pointer<int>>>);
+        assert(sequence::same(s, sequence::array(t)));
+
+        // unsized, grows past the first chunk
+        auto e = materialize(sequence::epsilon(sequence::geometric<double>(1, .5)), a);
+        assert(53 == length(e));
+        assert(1 == *e);
+        assert(std::ldexp(1., -52) == back(e));
+
+        auto m = a.tell();
+        materialize(sequence::array(t), a);
+        a.rewind(m);
+        assert(m.p == a.tell().p);
+        a.reset();
+        auto s2 = materialize(sequence::array(t), a);
+        assert(sequence::same(s2, sequence::array(t)));
+    }
+    {
+        {
+            sequence::scratch_scope scope;
+            auto s = materialize(sequence::epsilon(sequence::power(.5)));
+            assert(53 == length(s));
+        }
+        auto m = sequence::scratch().tell();
+        {
+            sequence::scratch_scope scope;
+            auto s = materialize(sequence::epsilon(sequence::power(.5)));
+            assert(53 == length(s));
+        }
+        assert(m.p == sequence::scratch().tell().p);
+    }
+}
+
+void test_random()
+{
+    using sequence::random::philox;
+
+    // known answers from Random123
+    assert((philox({ 0, 0, 0, 0 }, { 0, 0 }) == sequence::random::ctr_type{ 0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8 }));
+    assert((philox({ 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff }, { 0xffffffff, 0xffffffff })
+        == sequence::random::ctr_type{ 0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd }));
+    {
+        sequence::uniform<> u(1234);
+        sequence::uniform<> u2(u);
+        assert(u == u2);
+
+        double v[100];
+        for (size_t i = 0; i < 100; ++i, ++u2) {
+            v[i] = *u2;
+            assert(0 < v[i] && v[i] < 1);
+        }
+
+        // jump ahead
+        for (size_t i : { 0, 1, 2, 7, 50, 99 }) {
+            assert(v[i] == *drop(i, u));
+        }
+
+        // batch fill matches element by element from any offset
+        for (size_t off : { 0, 1, 3 }) {
+            double w[80];
+            auto u3 = drop(off, u);
+            u3.fill(w, 80);
+            for (size_t i = 0; i < 80; ++i) {
+                assert(w[i] == v[off + i]);
+            }
+            assert(*u3 == v[off + 80]);
+        }
+
+        // substreams differ
+        assert(*u.substream(1) != *u.substream(2));
+        assert(*u.substream(0) == *u);
+
+        double mean = sum(sequence::take(100000, u)) / 100000;
+        assert(std::fabs(mean - 0.5) < 0.01);
+    }
+    {
+        // float stays in the open interval at the extremes of the random bits
+        using sequence::random::to_uniform;
+        assert(to_uniform(0u) > 0);
+        assert(to_uniform(0xFFFFFFFFu) < 1);
+        assert(static_cast<float>(to_uniform(0xFFFFFFFFu, 0xFFFFFFFFu)) == 1);
+
+        sequence::uniform<float> u(1234);
+        float v[1000];
+        auto u2 = u;
+        u2.fill(v, 1000);
+        for (size_t i = 0; i < 1000; ++i) {
+            assert(0 < v[i] && v[i] < 1);
+            assert(v[i] == *drop(i, u));
+        }
+    }
+    {
+        sequence::normal<> z(42, 7);
+        double v[64];
+        auto z2 = z;
+        z2.fill(v, 64);
+        assert(v[63] == *drop(63, z));
+        assert(*z2 == *drop(64, z));
+
+        auto zz = sequence::take(100000, z);
+        double mean = sum(zz) / 100000;
+        double var = sum(zz * zz) / 100000 - mean * mean;
+        assert(std::fabs(mean) < 0.02);
+        assert(std::fabs(var - 1) < 0.02);
+    }
+}
+
+void test_dual()
+{
+    using sequence::dual;
+    using sequence::epsilon;
+    using sequence::power;
+    using sequence::factorial;
+    using sequence::constant;
+    using sequence::take;
+
+    {
+        auto x = dual<>::variable(1);
+        assert(x.value() == 1 && x[0] == 1);
+        auto y = x * x * 3 + 1;
+        assert(y.value() == 4 && y[0] == 6);
+        y = 1 / x;
+        assert(y.value() == 1 && y[0] == -1);
+        assert(x != 2);
+        assert(x + 1 != 1);
+        assert(exp(x).value() == std::exp(1.) && exp(x)[0] == std::exp(1.));
+        assert(log(x)[0] == 1);
+        assert(sqrt(x * 4)[0] == 1);
+    }
+    {
+        // d/dx exp(x) = exp(x) in a single pass
+        auto x = dual<>::variable(1);
+        auto s = epsilon(power(x) / factorial<>());
+        auto ex = sum(s);
+        assert(std::fabs(ex.value() - std::exp(1.)) <= 4 * std::numeric_limits<double>::epsilon());
+        assert(std::fabs(ex[0] - std::exp(1.)) <= 4 * std::numeric_limits<double>::epsilon());
+
+        auto hx = horner(epsilon(constant(1) / factorial<>()), x);
+        assert(std::fabs(hx.value() - std::exp(1.)) <= 4 * std::numeric_limits<double>::epsilon());
+        assert(std::fabs(hx[0] - std::exp(1.)) <= 4 * std::numeric_limits<double>::epsilon());
+    }
+    {
+        // gradient of sum_n (xy)^n in both directions
+        using dual2 = dual<double, 2>;
+        auto x = dual2::variable(.5, 0);
+        auto y = dual2::variable(.25, 1);
+        auto f = sum(take(4, power(x) * power(y)));
+        double xy = .5 * .25;
+        assert(f.value() == 1 + xy + xy * xy + xy * xy * xy);
+        // d/dx = y (1 + 2xy + 3(xy)^2), d/dy = x (1 + 2xy + 3(xy)^2)
+        assert(std::fabs(f[0] - .25 * (1 + 2 * xy + 3 * xy * xy)) < 1e-15);
+        assert(std::fabs(f[1] - .5 * (1 + 2 * xy + 3 * xy * xy)) < 1e-15);
+    }
+}
+
+void test_rewrite()
+{
+    using sequence::constant;
+    using sequence::power;
+    using sequence::factorial;
+    using sequence::geometric;
+    using sequence::epsilon;
+    using sequence::take;
+
+    {
+        auto c = constant(2) + constant(3.);
+        static_assert(std::is_same_v<decltype(c), constant<double>>);
+        assert(*c == 5);
+        assert(*(constant(6) / constant(4)) == 1);
+        assert(*(constant(2) * constant(3)) == 6);
+        assert(*(constant(2) - constant(3)) == -1);
+    }
+    {
+        int t[] = { 1,2,3 };
+        auto s = constant(2) * sequence::array(t);
+        static_assert(std::is_same_v<decltype(s), sequence::scale<sequence::take<sequence::pointer<int>>>>);
+        assert(3 == length(s));
+        assert(12 == sum(s));
+        assert(12 == sum(sequence::array(t) * constant(2)));
+    }
+    {
+        auto g = geometric<double>(2, .5) * geometric<double>(3, .5);
+        static_assert(std::is_same_v<decltype(g), geometric<double>>);
+        assert(*g == 6);
+        ++g;
+        assert(*g == 1.5);
+
+        auto p = power(2.) * power(3.);
+        static_assert(std::is_same_v<decltype(p), power<double>>);
+        ++p;
+        ++p;
+        assert(*p == 36);
+    }
+    {
+        auto s = power(2.) / factorial<>();
+        static_assert(std::is_same_v<decltype(s), sequence::power_factorial<double>>);
+        assert(*s == 1);
+        ++s;
+        assert(*s == 2);
+        ++s;
+        assert(*s == 2);
+        ++s;
+        assert(*s == 8. / 6);
+
+        // rewriting from a later position
+        auto p = power(2.);
+        ++p;
+        auto f = factorial<>();
+        ++f;
+        ++f;
+        auto s2 = p / f;
+        assert(*s2 == 1); // 2^1/2!
+        ++s2;
+        assert(*s2 == 2. / 3); // 2^2/3!
+
+        // integer division is not rewritten
+        auto i = power(2) / factorial<int>();
+        static_assert(!std::is_same_v<decltype(i), sequence::power_factorial<int>>);
+    }
+    {
+        // x^n and n! overflow separately but their ratio does not
+        double x = 100;
+        double ex = sum(epsilon(power(x) / factorial<>()));
+        assert(std::fabs(ex / std::exp(x) - 1) < 1e-13);
+
+        // fused recurrence versus the binop it replaces, per term
+        x = 1;
+        auto f = epsilon(power(x) / factorial<>());
+        auto h = epsilon(sequence::binop(std::divides<double>{}, power(x), factorial<>()));
+        double r = 0;
+        bench("sum(epsilon(pow/fact)) fused", [&]() { r += sum(f); }, length(f), 10000);
+        bench("sum(epsilon(binop(pow, fact)))", [&]() { r += sum(h); }, length(h), 10000);
+        assert(r == r);
+    }
+}
+
+void test_reduce_many()
+{
+    using namespace sequence::reducer;
+    using sequence::reduce_many;
+
+    {
+        double t[] = { 3,1,4,1,5 };
+        auto [s, p, n, lo, hi, m] = reduce_many(sequence::array(t),
+            sum<>{}, product<>{}, count{}, min<>{}, max<>{}, moments<>{});
+        assert(s.value() == 14);
+        assert(p.value() == 60);
+        assert(n.value() == 5);
+        assert(lo.value() == 1);
+        assert(hi.value() == 5);
+        assert(m.count() == 5);
+        assert(std::fabs(m.mean() - 2.8) < 1e-15);
+        assert(std::fabs(m.variance() - 3.2) < 1e-14);
+    }
+    {
+        // same results from the element by element path
+        int t[] = { 3,1,4,1,5,0 };
+        auto [s, lo, hi] = reduce_many(sequence::null<int>(t), sum<int>{}, min<int>{}, max<int>{});
+        assert(s.value() == 14 && lo.value() == 1 && hi.value() == 5);
+        auto [n] = reduce_many(sequence::epsilon(sequence::geometric<double>(1, .5)), count{});
+        assert(n.value() == 53);
+    }
+    {
+        // batch path through fill()
+        auto u = sequence::take(1000, sequence::uniform<>(1));
+        auto [s, m, lo, hi] = reduce_many(u, sum<>{}, moments<>{}, min<>{}, max<>{});
+        assert(s.value() == sequence::sum(u));
+        assert(std::fabs(m.mean() - s.value() / 1000) < 1e-14);
+        assert(0 < lo.value() && hi.value() < 1);
+        auto [s2] = reduce_many(sequence::take(1000, sequence::uniform<>(1)) + sequence::constant(0.), sum<>{});
+        assert(std::fabs(s2.value() - s.value()) < 1e-12);
+    }
+}
+
+void test_rolling()
+{
+    using sequence::roll;
+    namespace window = sequence::window;
+
+    double t[100];
+    sequence::normal<>(3).fill(t, 100);
+    auto a = sequence::array(t);
+
+    for (size_t w : { 1, 2, 7, 100, 150 }) {
+        auto rs = roll<window::sum>(w, a);
+        auto rm = roll<window::mean>(w, a);
+        auto rv = roll<window::variance>(w, a);
+        auto rmin = roll<window::min>(w, a);
+        auto rmax = roll<window::max>(w, a);
+        assert(100 == length(rs));
+        for (size_t i = 0; i < 100; ++i) {
+            size_t n = (std::min)(i + 1, w);
+            auto s = sequence::take(n, sequence::pointer(t + i + 1 - n));
+            double mean = sequence::sum(s) / n;
+            double var = 0;
+            for (size_t j = 0; j < n; ++j) {
+                var += (t[i + 1 - n + j] - mean) * (t[i + 1 - n + j] - mean);
+            }
+            var = n > 1 ? var / (n - 1) : 0;
+            double lo = t[i + 1 - n], hi = lo;
+            for (size_t j = 0; j < n; ++j) {
+                lo = (std::min)(lo, t[i + 1 - n + j]);
+                hi = (std::max)(hi, t[i + 1 - n + j]);
+            }
+
+            assert(rs && rm && rv && rmin && rmax);
+            assert(std::fabs(*rs - sequence::sum(s)) < 1e-12);
+            assert(std::fabs(*rm - mean) < 1e-12);
+            assert(std::fabs(*rv - var) < 1e-12);
+            assert(*rmin == lo);
+            assert(*rmax == hi);
+            ++rs, ++rm, ++rv, ++rmin, ++rmax;
+        }
+        assert(!rs && !rm && !rv && !rmin && !rmax);
+    }
+    {
+        // removal does not accumulate error over long inputs with an outlier
+        constexpr size_t n = 2'000'000, w = 250, spike = 1'000'000;
+        std::vector<double> u(n);
+        sequence::normal<>(5).fill(u.data(), n);
+        for (auto& ui : u) {
+            ui = 100 + 0.01 * ui;
+        }
+        u[spike] = 1e12;
+
+        auto rs = roll<window::sum>(w, sequence::array(n, u.data()));
+        auto rv = roll<window::variance>(w, sequence::array(n, u.data()));
+        for (size_t i = 0; i < n; ++i, ++rs, ++rv) {
+            bool check = i % 9973 == 0 || (i >= spike + w && i < spike + 2 * w) || i == n - 1;
+            if (check && i >= w && (i < spike || i >= spike + w)) {
+                auto s = sequence::take(w, sequence::pointer(u.data() + i + 1 - w));
+                double mean = sequence::sum(s) / w;
+                double var = 0;
+                for (size_t j = i + 1 - w; j <= i; ++j) {
+                    var += (u[j] - mean) * (u[j] - mean);
+                }
+                var /= w - 1;
+                assert(std::fabs(*rs - sequence::sum(s)) < 1e-10 * mean * w);
+                assert(std::fabs(*rv - var) < 1e-8 * var);
+            }
+        }
+        assert(!rs && !rv);
+    }
+    {
+        // compile time window
+        auto r = roll<window::max, 3>(a);
+        static_assert(std::is_same_v<decltype(r), sequence::rolling<window::max, decltype(a), 3>>);
+        auto r_ = roll<window::max>(3, a);
+        assert(sequence::same(r, r_));
+
+        int u[] = { 1,2,3,4,5 };
+        auto m = roll<window::mean, 2>(sequence::array(u));
+        assert(*m == 1);
+        ++m;
+        assert(*m == 1.5);
+        ++m;
+        assert(*m == 2.5);
+    }
+    {
+        double u[] = { 1, 2, 3 };
+        auto e = sequence::ewma(.5, sequence::array(u));
+        assert(3 == length(e));
+        assert(*e == 1);
+        ++e;
+        assert(*e == 1.5);
+        ++e;
+        assert(*e == 2.25);
+        ++e;
+        assert(!e);
+    }
+}
+
+void test_merge()
+{
+    using sequence::array;
+
+    auto less = std::less<int>{};
+    {
+        int a[] = { 1,4,7 };
+        int b[] = { 2,5 };
+        int c[] = { 0,3,6,8 };
+        auto m = sequence::merge(less, array(a), array(b), array(c));
+        assert(9 == length(m));
+        int d[] = { 0,1,2,3,4,5,6,7,8 };
+        assert(sequence::same(m, array(d)));
+        assert(8 == back(m));
+
+        // empty sequences
+        auto m2 = sequence::merge(less, array(0, a), array(b));
+        assert(sequence::same(m2, array(b)));
+    }
+    {
+        // ties go to the earlier sequence
+        auto key = [](double x, double y) { return std::floor(x) < std::floor(y); };
+        double a[] = { 1.1, 2.1, 2.2 };
+        double b[] = { 1.2, 2.3 };
+        double c[] = { 1.3 };
+        double d[] = { 1.1, 1.2, 1.3, 2.1, 2.2, 2.3 };
+        assert(sequence::same(sequence::merge(key, array(a), array(b), array(c)), array(d)));
+
+        std::vector<sequence::take<sequence::pointer<double>>> v{ array(a), array(b), array(c) };
+        auto m = sequence::merge_tree(key, v);
+        assert(6 == length(m));
+        assert(sequence::same(m, array(d)));
+    }
+    {
+        // many interleaved sequences
+        constexpr size_t K = 13, M = 20;
+        int t[K][M];
+        std::vector<sequence::take<sequence::pointer<int>>> v;
+        for (size_t k = 0; k < K; ++k) {
+            for (size_t j = 0; j < M; ++j) {
+                t[k][j] = static_cast<int>(j * K + (K - 1 - k));
+            }
+            v.push_back(array(k % 3 ? M : M - 5, t[k]));
+        }
+        auto m = sequence::merge_tree(less, v);
+        size_t n = length(m);
+        assert(n == K * M - 5 * ((K + 2) / 3));
+        int prev = -1;
+        while (m) {
+            assert(prev < *m);
+            prev = *m;
+            ++m;
+            --n;
+        }
+        assert(n == 0);
+
+        assert(!sequence::merge_tree(less, std::vector<sequence::take<sequence::pointer<int>>>{}));
+        auto m1 = sequence::merge_tree(less, std::vector<sequence::take<sequence::pointer<int>>>{ array(3, t[0]) });
+        assert(sequence::same(m1, array(3, t[0])));
+    }
+}
+
+template<class Codec, class T>
+void check_compressed(const std::vector<T>& t, size_t B)
+{
+    sequence::compressed<Codec> c(sequence::array(t.size(), t.data()), B);
+    assert(c.size() == t.size());
+    assert(c.blocks() == (t.size() + B - 1) / B);
+
+    auto s = c.sequence();
+    assert(t.size() == length(s));
+    assert(sequence::same(s, sequence::array(t.size(), t.data())));
+
+    // skip into the middle of blocks
+    for (size_t i : { size_t(0), size_t(1), B - 1, B, B + 1, t.size() / 2, t.size() - 1, t.size(), t.size() + 1 }) {
+        auto si = drop(i, s);
+        assert(length(si) == (i < t.size() ? t.size() - i : 0));
+        if (i < t.size()) {
+            assert(*si == t[i]);
+        }
+    }
+
+    // batch decode from unaligned starts
+    std::vector<T> u(t.size());
+    for (size_t off : { size_t(0), size_t(3), B }) {
+        if (off < t.size()) {
+            auto so = drop(off, s);
+            so.fill(u.data(), t.size() - off);
+            assert(!so);
+            for (size_t i = 0; i < t.size() - off; ++i) {
+                assert(u[i] == t[off + i]);
+            }
+        }
+    }
+
+    // blocks decode independently in any order
+    for (size_t i = c.blocks(); i--; ) {
+        c.decode(i, u.data() + i * B);
+    }
+    assert(u == t);
+}
+
+void test_compress()
+{
+    using sequence::codec::delta_varint;
+    using sequence::codec::gorilla;
+
+    {
+        // timestamps with small increments
+        std::vector<int64_t> t(1000);
+        int64_t x = 1'600'000'000'000;
+        for (size_t i = 0; i < t.size(); ++i) {
+            t[i] = x += 1 + static_cast<int64_t>(i % 5);
+        }
+        check_compressed<delta_varint<int64_t>>(t, 64);
+        check_compressed<delta_varint<int64_t>>(t, 1000);
+        check_compressed<delta_varint<int64_t>>(t, 7);
+
+        sequence::delta_compressed<int64_t> c(sequence::array(t.size(), t.data()));
+        assert(c.bytes_size() * 6 < t.size() * sizeof(int64_t));
+        assert(sum(c.sequence()) == sum(sequence::array(t.size(), t.data())));
+    }
+    {
+        std::vector<int> t = { 0, -1, 1, std::numeric_limits<int>::max(), std::numeric_limits<int>::min(), 5, 5 };
+        check_compressed<delta_varint<int>>(t, 3);
+        std::vector<uint64_t> u = { 0, std::numeric_limits<uint64_t>::max(), 1, 2 };
+        check_compressed<delta_varint<uint64_t>>(u, 4);
+    }
+    {
+        // slowly varying prices
+        std::vector<double> t(1000);
+        for (size_t i = 0; i < t.size(); ++i) {
+            t[i] = 100 + 0.25 * static_cast<double>((i / 10) % 7);
+        }
+        check_compressed<gorilla>(t, 128);
+        sequence::xor_compressed c(sequence::array(t.size(), t.data()));
+        assert(c.bytes_size() * 10 < t.size() * sizeof(double));
+
+        // batch path of reduce_many
+        auto [s] = sequence::reduce_many(sequence::take(1000, c.sequence()), sequence::reducer::sum<>{});
+        assert(s.value() == sum(sequence::array(t.size(), t.data())));
+    }
+    {
+        std::vector<double> t(300);
+        sequence::normal<>(5).fill(t.data(), t.size());
+        t[10] = t[11] = t[12];
+        t[20] = 0;
+        t[21] = -0.;
+        t[22] = std::numeric_limits<double>::infinity();
+        t[23] = std::numeric_limits<double>::denorm_min();
+        check_compressed<gorilla>(t, 50);
+        check_compressed<gorilla>(std::vector<double>{ 1.5 }, 50);
+        check_compressed<gorilla>(std::vector<double>{}, 50);
+    }
+}
+
+void test_recurrence()
+{
+    using sequence::recurrence;
+
+    {
+        // Fibonacci
+        recurrence<uint64_t, 2> f({ 1, 1 }, { 0, 1 });
+        uint64_t t[] = { 0,1,1,2,3,5,8,13,21,34 };
+        assert(sequence::same(sequence::take(10, f), sequence::array(t)));
+        assert(*drop(90, f) == 2880067194370816120ull);
+        assert(*drop(93, f) == 12200160415121876738ull);
+
+        auto f1 = f;
+        for (size_t i = 0; i < 500; ++i) {
+            ++f1;
+        }
+        assert(*drop(500, f) == *f1); // exact modulo 2^64
+        assert(*drop(0, f) == 0);
+    }
+    {
+        // AR(3) without noise, jump versus step
+        recurrence<double, 3> r({ .5, .3, .1 }, { 1, 2, 3 });
+        auto r1 = r;
+        for (size_t i = 0; i < 200; ++i) {
+            ++r1;
+        }
+        double x = *drop(200, r);
+        assert(std::fabs(x - *r1) <= 1e-12 * std::fabs(*r1));
+
+        // split into independent pieces
+        auto a = sequence::take(100, r);
+        auto b = sequence::take(100, drop(100, r));
+        double sa = sum(a), sb = sum(b);
+        assert(std::fabs(sa + sb - sum(sequence::take(200, r))) < 1e-12 * std::fabs(sa + sb));
+    }
+}
+
+// partial numerators and denominators of erfc(x) exp(x^2) sqrt(pi)
+inline auto erfc_cf(double x)
+{
+    using sequence::concatenate;
+    using sequence::take;
+    using sequence::constant;
+
+    auto a = concatenate(take(1, constant(1.)), sequence::linear<double>(.5, .5));
+    auto b = concatenate(take(1, constant(0.)), constant(x));
+
+    return std::pair(a, b);
+}
+
+void test_continued_fraction()
+{
+    using sequence::continued_fraction;
+    using sequence::epsilon;
+    using sequence::power;
+    using sequence::factorial;
+    using sequence::constant;
+
+    {
+        // golden ratio 1 + 1/(1 + 1/(1 + ...))
+        double phi = continued_fraction(constant(1.), constant(1.));
+        assert(std::fabs(phi - (1 + std::sqrt(5.)) / 2) <= 2 * std::numeric_limits<double>::epsilon());
+
+        // finite fractions stop when the inputs do: 1 + 1/(2 + 1/3) = 10/7
+        double a[] = { 1, 1 };
+        double b[] = { 1, 2, 3 };
+        assert(std::fabs(continued_fraction(sequence::array(a), sequence::array(b)) - 10. / 7) < 1e-15);
+    }
+    {
+        const double sqrt_pi = std::sqrt(3.14159265358979323846);
+        for (double x : { 2., 3., 5. }) {
+            auto [a, b] = erfc_cf(x);
+            double y = std::exp(-x * x) / sqrt_pi * continued_fraction(a, b);
+            assert(std::fabs(y / std::erfc(x) - 1) < 1e-14);
+        }
+
+        // batch
+        double x[] = { 2, 3, 4, 5 }, y[4];
+        continued_fraction(erfc_cf, x, 4, y);
+        for (size_t i = 0; i < 4; ++i) {
+            assert(std::fabs(std::exp(-x[i] * x[i]) / sqrt_pi * y[i] / std::erfc(x[i]) - 1) < 1e-14);
+        }
+
+        // terms needed by the fraction versus the series for erf(3)
+        double x0 = 3;
+        auto [a, b] = erfc_cf(x0);
+        size_t n_cf = length(sequence::lentz(a, b));
+        auto series = epsilon(constant(x0) * (power(-x0 * x0) / factorial<>()) / sequence::linear<double>(1, 2));
+        size_t n_series = length(series);
+        assert(n_cf < n_series);
+
+        // per call, the fraction needs fewer terms
+        double r = 0;
+        bench("continued_fraction erfc(3)", [&, a = a, b = b]() { r += continued_fraction(a, b); }, 1, 10000);
+        bench("sum(series) erf(3)", [&]() { r += sum(series); }, 1, 10000);
+        assert(r == r);
+    }
+}
+
+// units in the last place between x and y
+inline double ulps(double x, double y)
+{
+    if (x == y) {
+        return 0;
+    }
+
+    return std::fabs(x - y) / (std::nextafter(std::fabs(y), HUGE_VAL) - std::fabs(y));
+}
+
+void test_elementary()
+{
+    namespace elementary = sequence::elementary;
 
+    {
+        static_assert(elementary::detail::exp_c[0] == 1);
+        static_assert(elementary::detail::exp_c[3] == 1. / 6);
+        static_assert(elementary::detail::expm1_c[1] == 1. / 2);
+        static_assert(elementary::detail::atanh_c[2] == 1. / 5);
+        // R(2) and R'(2) = 2 R(2) - 1 for the Mills ratio R
+        constexpr double sqrt2pi = 2.5066282746310002, R2 = 0.42136922928805448;
+        assert(std::fabs(elementary::detail::mills_c[0] * sqrt2pi - R2) < 1e-16);
+        assert(std::fabs(elementary::detail::mills_c[1] * sqrt2pi - (2 * R2 - 1)) < 1e-16);
+    }
+    {
+        for (double x = -700; x <= 700; x += 0.37) {
+            assert(ulps(elementary::exp(x), std::exp(x)) <= 2);
+            assert(ulps(elementary::expm1(x), std::expm1(x)) <= 3);
+        }
+        for (double x = -1; x <= 1; x += 1. / 1024) {
+            assert(ulps(elementary::expm1(x), std::expm1(x)) <= 2);
+        }
+        for (double x : { 1e-300, 1e-20, -1e-20 }) {
+            assert(ulps(elementary::expm1(x), std::expm1(x)) <= 1);
+        }
+        // subnormal and overflowing results
+        for (double x : { -740., -745., 709.7 }) {
+            assert(ulps(elementary::exp(x), std::exp(x)) <= 2);
+        }
+        assert(elementary::exp(-800) == 0);
+        assert(elementary::exp(709.9) == HUGE_VAL);
+        assert(elementary::exp(710) == HUGE_VAL);
+        assert(elementary::exp(-HUGE_VAL) == 0);
+        assert(elementary::exp(HUGE_VAL) == HUGE_VAL);
+        assert(std::isnan(elementary::exp(std::nan(""))));
+        assert(elementary::expm1(-HUGE_VAL) == -1);
+        assert(elementary::expm1(HUGE_VAL) == HUGE_VAL);
+    }
+    {
+        for (double x = 1e-300; x < 1e300; x *= 1.37) {
+            assert(ulps(elementary::log(x), std::log(x)) <= 2);
+        }
+        for (double x = 0.5; x < 2; x += 1. / 1024) {
+            assert(ulps(elementary::log(x), std::log(x)) <= 2);
+        }
+        double d = std::numeric_limits<double>::denorm_min();
+        assert(ulps(elementary::log(d), std::log(d)) <= 1);
+        assert(elementary::log(0) == -HUGE_VAL);
+        assert(elementary::log(HUGE_VAL) == HUGE_VAL);
+        assert(std::isnan(elementary::log(-1)));
+        assert(std::isnan(elementary::log(std::nan(""))));
+    }
+    {
+        // relative accuracy down to the smallest normal result
+        for (double x = -37.5; x <= 9; x += 1. / 64) {
+            long double N = std::erfc(-x / std::sqrt(2.L)) / 2;
+            assert(std::fabs(elementary::normal_cdf(x) - N) <= 4 * DBL_EPSILON * N);
+            assert(std::fabs(elementary::detail::normal_cdf_erfc(x) - N) <= 4 * DBL_EPSILON * N);
+        }
+        assert(elementary::detail::normal_cdf_erfc(-HUGE_VAL) == 0);
+        assert(elementary::detail::normal_cdf_erfc(HUGE_VAL) == 1);
+        assert(elementary::normal_cdf(-40) >= 0);
+        assert(elementary::normal_cdf(-HUGE_VAL) == 0);
+        assert(elementary::normal_cdf(HUGE_VAL) == 1);
+        assert(std::isnan(elementary::normal_cdf(std::nan(""))));
+    }
+    {
+        // batches over sequences
+        double x[] = { -1, 0, 0.5, 2 }, y[4];
+
+        assert(4 == elementary::exp(sequence::array(x), y));
+        for (size_t i = 0; i < 4; ++i) {
+            assert(y[i] == elementary::exp(x[i]));
+        }
+        assert(4 == elementary::log(sequence::take(4, sequence::linear<double>(1)), y));
+        for (size_t i = 0; i < 4; ++i) {
+            assert(y[i] == elementary::log(1. + i));
+        }
+        assert(4 == elementary::normal_cdf(sequence::array(x), y));
+        assert(y[1] == 0.5);
+    }
+    {
+        // packed kernels and the scalar tail, n is not a multiple of the pack size
+        constexpr size_t n = 1001;
+        double x[n], y[n];
+
+        for (size_t i = 0; i < n; ++i) {
+            x[i] = -700 + 1400. * i / n;
+        }
+        elementary::exp(x, n, y);
+        for (size_t i = 0; i < n; ++i) {
+            assert(ulps(y[i], std::exp(x[i])) <= 2);
+        }
+        elementary::expm1(x, n, y);
+        for (size_t i = 0; i < n; ++i) {
+            assert(ulps(y[i], std::expm1(x[i])) <= 3);
+        }
+        x[0] = 0;
+        x[1] = -1;
+        x[2] = HUGE_VAL;
+        x[3] = std::numeric_limits<double>::denorm_min();
+        for (size_t i = 4; i < n; ++i) {
+            x[i] = std::ldexp(1 + i / 997., static_cast<int>(i % 2001) - 1000);
+        }
+        elementary::log(x, n, y);
+        assert(y[0] == -HUGE_VAL);
+        assert(std::isnan(y[1]));
+        assert(y[2] == HUGE_VAL);
+        for (size_t i = 3; i < n; ++i) {
+            assert(ulps(y[i], std::log(x[i])) <= 2);
+        }
+        for (size_t i = 0; i < n; ++i) {
+            x[i] = -37.5 + 46.5 * i / n;
+        }
+        elementary::normal_cdf(x, n, y);
+        for (size_t i = 0; i < n; ++i) {
+            long double N = std::erfc(-x[i] / std::sqrt(2.L)) / 2;
+            assert(std::fabs(y[i] - N) <= 4 * DBL_EPSILON * N);
+        }
+    }
+    {
+        constexpr size_t n = 1000;
+        double x[n], y[n];
+        for (size_t i = 0; i < n; ++i) {
+            x[i] = -10 + 20. * i / n;
+        }
+
+        // table kernel versus libm versus summing the series per element
+        bench("elementary::exp [-10, 10]", [&]() { elementary::exp(sequence::array(x), y); }, n, 1000);
+        bench("std::exp [-10, 10]", [&]() { for (size_t i = 0; i < n; ++i) y[i] = std::exp(x[i]); }, n, 1000);
+        bench("series exp [-10, 10]", [&]() {
+            for (size_t i = 0; i < n; ++i) {
+                y[i] = sequence::sum(sequence::epsilon(sequence::power(x[i]) / sequence::factorial<>()));
+            }
+        }, n, 10);
+        assert(y[0] == y[0]);
+    }
+}
+
+void test_perf()
+{
+    using sequence::perf::event;
+
+    {
+        sequence::perf::counters c;
+        c.start();
+        volatile double x = 0;
+        for (int i = 0; i < 1000; ++i) {
+            x = x + i;
+        }
+        auto s = c.stop();
+        for (int e = 0; e < sequence::perf::events; ++e) {
+            assert(s.valid(event(e)) == c.available(event(e)));
+        }
+        if (c.available(event::instructions)) {
+            assert(s.count[event::instructions] >= 1000);
+        }
+    }
+    {
+        auto s = sequence::perf::measure([]() {}, 10, 3);
+        assert(s.n == 30);
+        assert(s.seconds >= 0);
+    }
+    {
+        // which of binop, epsilon and the reductions to optimize next
+        constexpr size_t n = 1000;
+        double a[n], b[n], y[n];
+        for (size_t i = 0; i < n; ++i) {
+            a[i] = 1. / (i + 1);
+            b[i] = i % 7 - 3.;
+        }
+        double r = 0;
+
+        bench("sum(array)", [&]() { r += sequence::sum(sequence::array(a)); }, n, 1000);
+        bench("sum(array * array)", [&]() { r += sequence::sum(sequence::array(a) * sequence::array(b)); }, n, 1000);
+        bench("reduce_many(array, sum, moments)", [&]() {
+            auto [s, m] = sequence::reduce_many(sequence::array(b), sequence::reducer::sum<>{}, sequence::reducer::moments<>{});
+            r += s.value() + m.mean();
+        }, n, 1000);
+        bench("sum(epsilon(power/factorial))", [&]() { r += sequence::sum(sequence::epsilon(sequence::power(b[0]) / sequence::factorial<>())); }, length(sequence::epsilon(sequence::power(b[0]) / sequence::factorial<>())), 1000);
+        bench("elementary::exp(array)", [&]() { sequence::elementary::exp(sequence::array(b), y); }, n, 1000);
+        bench("std::exp", [&]() { for (size_t i = 0; i < n; ++i) y[i] = std::exp(b[i]); }, n, 1000);
+        bench("elementary::log(array)", [&]() { sequence::elementary::log(sequence::array(a), y); }, n, 1000);
+        bench("std::log", [&]() { for (size_t i = 0; i < n; ++i) y[i] = std::log(a[i]); }, n, 1000);
+        bench("elementary::normal_cdf(array)", [&]() { sequence::elementary::normal_cdf(sequence::array(b), y); }, n, 1000);
+        bench("std::erfc", [&]() { for (size_t i = 0; i < n; ++i) y[i] = std::erfc(-b[i] / std::sqrt(2.)) / 2; }, n, 1000);
+        assert(r == r);
     }
 }
 
@@ -428,6 +1416,13 @@ int main()
     test_null<float>();
     test_null<double>();
 
+    test_scan<char>();
+    test_scan<int>();
+    test_scan<unsigned>();
+    test_scan<long>();
+    test_scan<float>();
+    test_scan<double>();
+
     test_iota();
 
     test_drop();
@@ -439,6 +1434,21 @@ int main()
     test_binop();
 
     test_concatenate<int>();
+    test_concatenate<double>();
+
+    test_size();
+    test_materialize();
+    test_random();
+    test_dual();
+    test_rewrite();
+    test_reduce_many();
+    test_rolling();
+    test_merge();
+    test_compress();
+    test_recurrence();
+    test_continued_fraction();
+    test_elementary();
+    test_perf();
 
     return 0;
 }
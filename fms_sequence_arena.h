@@ -0,0 +1,215 @@
+// fms_sequence_arena.h - materialize sequences into arena allocated storage
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include "fms_sequence.h"
+
+namespace fms::sequence {
+
+    // monotonic allocator that frees everything at once
+    // chunks are kept after reset() so steady state use never calls malloc
+    class arena {
+        struct chunk {
+            chunk* next;
+            size_t size; // bytes of storage following the header
+            char* data()
+            {
+                return reinterpret_cast<char*>(this + 1);
+            }
+        };
+        chunk* head; // first chunk
+        chunk* cur;  // chunk being allocated from
+        char* p;     // next free byte in cur
+        char* end;   // one past last byte of cur
+        size_t chunk_size;
+    public:
+        // position in the arena that can be rewound to
+        struct mark {
+            chunk* cur;
+            char* p;
+        };
+
+        explicit arena(size_t chunk_size = 4096) noexcept
+            : head(nullptr), cur(nullptr), p(nullptr), end(nullptr), chunk_size(chunk_size)
+        { }
+        arena(const arena&) = delete;
+        arena& operator=(const arena&) = delete;
+        ~arena()
+        {
+            while (head) {
+                chunk* next = head->next;
+                ::operator delete(head);
+                head = next;
+            }
+        }
+
+        // n bytes aligned to align
+        void* allocate(size_t n, size_t align = alignof(std::max_align_t))
+        {
+            char* q = align_up(p, align);
+            if (!cur || q + n > end) {
+                next_chunk(n + align);
+                q = align_up(p, align);
+            }
+            p = q + n;
+
+            return q;
+        }
+        template<class T>
+        T* allocate(size_t n)
+        {
+            static_assert(std::is_trivially_destructible_v<T>, "arena never calls destructors");
+            if (n > (std::numeric_limits<size_t>::max)() / sizeof(T)) {
+                throw std::length_error("fms::sequence::arena::allocate: too many elements");
+            }
+
+            return static_cast<T*>(allocate(n * sizeof(T), alignof(T)));
+        }
+
+        // grow the most recent allocation in place from n to m bytes if there is room
+        bool extend(void* q, size_t n, size_t m) noexcept
+        {
+            char* c = static_cast<char*>(q);
+            if (c + n != p || c + m > end) {
+                return false;
+            }
+            p = c + m;
+
+            return true;
+        }
+
+        mark tell() const noexcept
+        {
+            return mark{ cur, p };
+        }
+        // free everything allocated after m
+        void rewind(mark m) noexcept
+        {
+            if (m.cur) {
+                cur = m.cur;
+                p = m.p;
+                end = cur->data() + cur->size;
+            }
+            else {
+                reset();
+            }
+        }
+        // free everything but keep the chunks
+        void reset() noexcept
+        {
+            cur = head;
+            p = cur ? cur->data() : nullptr;
+            end = cur ? p + cur->size : nullptr;
+        }
+    private:
+        static char* align_up(char* q, size_t align) noexcept
+        {
+            auto u = reinterpret_cast<std::uintptr_t>(q);
+
+            return reinterpret_cast<char*>((u + align - 1) & ~(std::uintptr_t(align) - 1));
+        }
+        // make a chunk with at least n bytes current
+        void next_chunk(size_t n)
+        {
+            // reuse chunks released by reset or rewind
+            chunk** pc = cur ? &cur->next : &head;
+            while (*pc && (*pc)->size < n) {
+                pc = &(*pc)->next;
+            }
+            if (!*pc) {
+                size_t size = (std::max)(n, chunk_size);
+                chunk* c = static_cast<chunk*>(::operator new(sizeof(chunk) + size));
+                c->next = nullptr;
+                c->size = size;
+                *pc = c;
+            }
+            else if (cur && *pc != cur->next) {
+                // move the chunk that fits directly after cur
+                chunk* c = *pc;
+                *pc = c->next;
+                c->next = cur->next;
+                cur->next = c;
+                pc = &cur->next;
+            }
+            cur = *pc;
+            p = cur->data();
+            end = p + cur->size;
+        }
+    };
+
+    // per thread arena for temporary materializations
+    inline arena& scratch()
+    {
+        thread_local arena a(1 << 16);
+
+        return a;
+    }
+
+    // free scratch allocations made during the lifetime of this object
+    class scratch_scope {
+        arena& a;
+        arena::mark m;
+    public:
+        scratch_scope(arena& a = scratch()) noexcept
+            : a(a), m(a.tell())
+        { }
+        scratch_scope(const scratch_scope&) = delete;
+        scratch_scope& operator=(const scratch_scope&) = delete;
+        ~scratch_scope()
+        {
+            a.rewind(m);
+        }
+    };
+
+    // copy the remaining elements of s into a and return an array over them
+    template<class S, class T = std::remove_cv_t<typename S::value_type>>
+    inline auto materialize(S s, arena& a)
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "materialized values are copied bitwise");
+
+        if constexpr (is_sized_v<S>) {
+            size_t n = s.size();
+            if (n == infinite) {
+                throw std::length_error("fms::sequence::materialize: infinite sequence");
+            }
+            T* t = a.allocate<T>(n);
+            for (size_t i = 0; i < n; ++i, ++s) {
+                ::new (t + i) T(*s);
+            }
+
+            return array(n, t);
+        }
+        else {
+            size_t n = 0, cap = 16;
+            T* t = a.allocate<T>(cap);
+            while (s) {
+                if (n == cap) {
+                    if (!a.extend(t, cap * sizeof(T), 2 * cap * sizeof(T))) {
+                        T* t_ = a.allocate<T>(2 * cap);
+                        std::memcpy(static_cast<void*>(t_), t, n * sizeof(T));
+                        t = t_;
+                    }
+                    cap *= 2;
+                }
+                ::new (t + n) T(*s);
+                ++n;
+                ++s;
+            }
+            // return unused capacity
+            a.extend(t, cap * sizeof(T), n * sizeof(T));
+
+            return array(n, t);
+        }
+    }
+    template<class S>
+    inline auto materialize(S s)
+    {
+        return materialize(s, scratch());
+    }
+
+} // namespace fms::sequence
@@ -0,0 +1,156 @@
+#!/bin/sh
+# fms_sequence_budget.sh - compile time and code size budget for deep sequence compositions
+#
+# usage: fms_sequence_budget.sh [budget file] [update]
+#
+# Generates translation units composing sequences to increasing depth and width,
+# compiles each with $CXX $CXXFLAGS and records
+#   time  best of five compile cpu times as a percentage of a translation unit
+#         that only includes fms_sequence.h, so budgets carry across machines
+#   text  size of the .text section in bytes
+#   insn  instructions in all code sections, f and every function it calls
+# and fails if any figure exceeds its budget by more than the tolerance.
+# Times are noisy so their tolerance is larger, sizes and instruction counts are exact.
+# Budgets are for the compiler recorded in the budget file, a different one is
+# reported and its budgets should be regenerated with update.
+# With update the budget file is rewritten from the measurements.
+
+CXX=${CXX:-c++}
+CXXFLAGS=${CXXFLAGS:--std=c++17 -O2}
+BUDGET=${1:-fms_sequence_budget.txt}
+MODE=${2:-check}
+TIME_TOLERANCE=${TIME_TOLERANCE:-100} # percent
+SIZE_TOLERANCE=${SIZE_TOLERANCE:-10}  # percent
+SRC=$(cd "$(dirname "$0")" && pwd)
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+
+# user and system time of finished child processes in ms from the output of times
+# times must run in this shell, not in a command substitution subshell
+children_ms()
+{
+    awk 'NR == 2 {
+        n = 0
+        for (i = 1; i <= 2; ++i) {
+            split($i, t, "m")
+            n += 60000 * t[1] + 1000 * t[2]
+        }
+        printf "%d\n", n
+    }' "$1"
+}
+
+# s_k: binop chain ((a + a) + a) + ... nesting k binops
+depth()
+{
+    e="sequence::array(n, a)"
+    i=0
+    while [ $i -lt "$1" ]; do
+        e="($e + sequence::array(n, a))"
+        i=$((i + 1))
+    done
+    echo "sequence::sum($e)"
+}
+
+# concatenate of k arrays
+width()
+{
+    e="sequence::array(n, a)"
+    i=1
+    while [ $i -lt "$1" ]; do
+        e="$e, sequence::array(n, a)"
+        i=$((i + 1))
+    done
+    echo "sequence::sum(sequence::concatenate($e))"
+}
+
+# horner of epsilon of a product of k power/factorial series
+series()
+{
+    e="(sequence::power(x) / sequence::factorial<>())"
+    i=1
+    while [ $i -lt "$1" ]; do
+        e="$e * (sequence::power(x) / sequence::factorial<>())"
+        i=$((i + 1))
+    done
+    echo "sequence::horner(sequence::epsilon($e), x)"
+}
+
+# compile body into $TMP/$1.o, print cpu ms, text bytes and instructions
+measure()
+{
+    cat > "$TMP/$1.cpp" <<EOF
+#include "fms_sequence.h"
+using namespace fms;
+extern "C" double f(const double* a, size_t n, double x)
+{
+    return $2;
+}
+EOF
+    ms=
+    for r in 1 2 3 4 5; do
+        times > "$TMP/t0"
+        $CXX $CXXFLAGS -I"$SRC" -c -o "$TMP/$1.o" "$TMP/$1.cpp" || exit 1
+        times > "$TMP/t1"
+        t0=$(children_ms "$TMP/t0")
+        t1=$(children_ms "$TMP/t1")
+        [ -z "$ms" ] || [ $((t1 - t0)) -lt "$ms" ] && ms=$((t1 - t0))
+    done
+    text=$(size -A "$TMP/$1.o" | awk '$1 ~ /^\.text/ { n += $2 } END { print n + 0 }')
+    insn=$(objdump -d --no-show-raw-insn "$TMP/$1.o" | awk '
+        /^Disassembly of section / { code = $4 ~ /^\.text/ }
+        code && /^ *[0-9a-f]+:\t/ { n++ }
+        END { print n + 0 }')
+    echo "$ms $text $insn"
+}
+
+# first line of --version without the program name, which differs for c++ and g++
+COMPILER=$($CXX --version | head -n 1 | sed 's/^[^ ]* //')
+
+set -- $(measure base "0")
+BASE=$1
+
+: > "$TMP/results"
+for k in 1 2 4 8 16; do
+    for shape in depth width series; do
+        set -- $(measure "${shape}_$k" "$($shape $k)")
+        printf '%-10s %6d %8d %6d\n' "${shape}_$k" "$((100 * $1 / BASE))" "$2" "$3" >> "$TMP/results"
+    done
+done
+
+if [ "$MODE" = update ]; then
+    {
+        echo "# compiler $COMPILER"
+        echo "# name time text insn, see fms_sequence_budget.sh"
+        cat "$TMP/results"
+    } > "$BUDGET"
+    cat "$BUDGET"
+    exit 0
+fi
+
+if [ ! -f "$BUDGET" ]; then
+    echo "$0: no budget file $BUDGET, run with update to create it" >&2
+    exit 1
+fi
+
+RECORDED=$(sed -n 's/^# compiler //p' "$BUDGET")
+if [ "$RECORDED" != "$COMPILER" ]; then
+    echo "$0: budgets were recorded with '${RECORDED:-unknown compiler}' but $CXX is '$COMPILER'," >&2
+    echo "$0: figures differ between compilers, regenerate with update after checking them" >&2
+fi
+
+# join measurements with the budget and compare each column
+awk -v tt="$TIME_TOLERANCE" -v st="$SIZE_TOLERANCE" '
+    FNR == NR { if ($1 !~ /^#/) { time[$1] = $2; text[$1] = $3; insn[$1] = $4 } next }
+    function check(what, got, want, tol) {
+        over = got > want * (1 + tol / 100) && got > want + (what == "time" ? 25 : 16)
+        printf "%-10s %-4s %8d %8d%s\n", $1, what, got, want, over ? "  over budget" : ""
+        return over
+    }
+    {
+        if (!($1 in time)) { printf "%-10s not in budget\n", $1; fail = 1; next }
+        fail += check("time", $2, time[$1], tt)
+        fail += check("text", $3, text[$1], st)
+        fail += check("insn", $4, insn[$1], st)
+    }
+    END { exit fail != 0 }
+' "$BUDGET" "$TMP/results"
@@ -0,0 +1,379 @@
+// fms_sequence_compress.h - compressed in memory sequences decoded on the fly
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+#include "fms_sequence.h"
+
+namespace fms::sequence {
+
+    // block encodings having encode(const T* t, size_t n, bytes) and a decoder with T next()
+    namespace codec {
+
+        inline void put_varint(std::vector<uint8_t>& out, uint64_t x)
+        {
+            while (x >= 0x80) {
+                out.push_back(static_cast<uint8_t>(x | 0x80));
+                x >>= 7;
+            }
+            out.push_back(static_cast<uint8_t>(x));
+        }
+        inline uint64_t get_varint(const uint8_t*& p) noexcept
+        {
+            uint64_t x = 0;
+            unsigned shift = 0;
+            uint8_t b;
+
+            do {
+                b = *p++;
+                x |= uint64_t(b & 0x7F) << shift;
+                shift += 7;
+            } while (b & 0x80);
+
+            return x;
+        }
+
+        // small magnitudes of either sign to small unsigned values
+        inline uint64_t zigzag(uint64_t d) noexcept
+        {
+            return (d << 1) ^ (0 - (d >> 63));
+        }
+        inline uint64_t unzigzag(uint64_t u) noexcept
+        {
+            return (u >> 1) ^ (0 - (u & 1));
+        }
+
+        // differences of consecutive integers as zigzag varints
+        template<class T>
+        struct delta_varint {
+            static_assert(std::is_integral_v<T>, "delta_varint encodes integers");
+            typedef T value_type;
+
+            static void encode(const T* t, size_t n, std::vector<uint8_t>& out)
+            {
+                uint64_t prev = 0;
+
+                for (size_t i = 0; i < n; ++i) {
+                    uint64_t x = static_cast<uint64_t>(t[i]);
+                    put_varint(out, zigzag(x - prev)); // wraps, exact for any T
+                    prev = x;
+                }
+            }
+
+            class decoder {
+                const uint8_t* p;
+                uint64_t prev;
+            public:
+                decoder(const uint8_t* p = nullptr) noexcept
+                    : p(p), prev(0)
+                { }
+                T next() noexcept
+                {
+                    prev += unzigzag(get_varint(p));
+
+                    return static_cast<T>(prev);
+                }
+            };
+        };
+
+        // most significant bit first
+        class bit_writer {
+            std::vector<uint8_t>& out;
+            unsigned n; // bits used in out.back()
+        public:
+            bit_writer(std::vector<uint8_t>& out) noexcept
+                : out(out), n(8)
+            { }
+            // low k <= 64 bits of x
+            void put(uint64_t x, unsigned k)
+            {
+                while (k) {
+                    if (n == 8) {
+                        out.push_back(0);
+                        n = 0;
+                    }
+                    unsigned m = k < 8 - n ? k : 8 - n;
+                    k -= m;
+                    out.back() |= static_cast<uint8_t>(((x >> k) & ((1u << m) - 1)) << (8 - n - m));
+                    n += m;
+                }
+            }
+        };
+        class bit_reader {
+            const uint8_t* p;
+            unsigned n; // bits left in *p
+        public:
+            bit_reader(const uint8_t* p = nullptr) noexcept
+                : p(p), n(8)
+            { }
+            uint64_t get(unsigned k) noexcept
+            {
+                uint64_t x = 0;
+
+                while (k) {
+                    unsigned m = k < n ? k : n;
+                    x = (x << m) | ((*p >> (n - m)) & ((1u << m) - 1));
+                    k -= m;
+                    n -= m;
+                    if (n == 0) {
+                        ++p;
+                        n = 8;
+                    }
+                }
+
+                return x;
+            }
+        };
+
+        // XOR of consecutive doubles with leading and trailing zero windows
+        // Pelkonen et al, "Gorilla: A Fast, Scalable, In-Memory Time Series Database"
+        struct gorilla {
+            typedef double value_type;
+
+            // 0: same value
+            // 10: meaningful bits fit the previous window
+            // 11: 5 bits of leading zeros, 6 bits of length (0 means 64), meaningful bits
+            static void encode(const double* t, size_t n, std::vector<uint8_t>& out)
+            {
+                if (n == 0) {
+                    return;
+                }
+
+                bit_writer w(out);
+                uint64_t prev = simd::bits(t[0]);
+                unsigned lead = 64, trail = 0; // no window yet
+
+                w.put(prev, 64);
+                for (size_t i = 1; i < n; ++i) {
+                    uint64_t u = simd::bits(t[i]);
+                    uint64_t x = u ^ prev;
+                    prev = u;
+                    if (x == 0) {
+                        w.put(0, 1);
+                    }
+                    else {
+                        unsigned l = simd::clz64(x), r = simd::ctz64(x);
+                        l = l > 31 ? 31 : l;
+                        if (lead != 64 && l >= lead && r >= trail) {
+                            w.put(0b10, 2);
+                            w.put(x >> trail, 64 - lead - trail);
+                        }
+                        else {
+                            lead = l;
+                            trail = r;
+                            unsigned m = 64 - lead - trail;
+                            w.put(0b11, 2);
+                            w.put(lead, 5);
+                            w.put(m & 63, 6);
+                            w.put(x >> trail, m);
+                        }
+                    }
+                }
+            }
+
+            class decoder {
+                bit_reader r;
+                uint64_t prev;
+                unsigned lead, trail;
+                bool first;
+            public:
+                decoder(const uint8_t* p = nullptr) noexcept
+                    : r(p), prev(0), lead(0), trail(0), first(true)
+                { }
+                double next() noexcept
+                {
+                    if (first) {
+                        first = false;
+                        prev = r.get(64);
+                    }
+                    else if (r.get(1)) {
+                        if (r.get(1)) {
+                            lead = static_cast<unsigned>(r.get(5));
+                            unsigned m = static_cast<unsigned>(r.get(6));
+                            trail = 64 - lead - (m ? m : 64);
+                        }
+                        prev ^= r.get(64 - lead - trail) << trail;
+                    }
+
+                    return simd::value(prev);
+                }
+            };
+        };
+
+    } // namespace codec
+
+    template<class Codec>
+    class compressed_sequence;
+
+    // blocks of B values encoded independently
+    // the block offsets allow O(1) skips and decoding blocks in parallel
+    template<class Codec>
+    class compressed {
+        std::vector<uint8_t> bytes;
+        std::vector<size_t> offset; // start of block i in bytes
+        size_t B, n;
+    public:
+        typedef typename Codec::value_type value_type;
+
+        template<class S>
+        compressed(S s, size_t B = 256)
+            : B(B), n(0)
+        {
+            if (B == 0) {
+                throw std::invalid_argument("fms::sequence::compressed: block size must be positive");
+            }
+
+            std::vector<value_type> t(B);
+            while (s) {
+                size_t m = 0;
+                while (m < B && s) {
+                    t[m++] = *s;
+                    ++s;
+                }
+                offset.push_back(bytes.size());
+                Codec::encode(t.data(), m, bytes);
+                n += m;
+            }
+        }
+
+        // number of values
+        size_t size() const noexcept
+        {
+            return n;
+        }
+        size_t block_size() const noexcept
+        {
+            return B;
+        }
+        size_t blocks() const noexcept
+        {
+            return offset.size();
+        }
+        // encoded size in bytes
+        size_t bytes_size() const noexcept
+        {
+            return bytes.size();
+        }
+        // number of values in block i
+        size_t count(size_t i) const noexcept
+        {
+            return i + 1 < offset.size() ? B : n - i * B;
+        }
+        typename Codec::decoder decoder(size_t i) const noexcept
+        {
+            return typename Codec::decoder(bytes.data() + offset[i]);
+        }
+        // decode block i into t, safe to call concurrently
+        size_t decode(size_t i, value_type* t) const
+        {
+            auto d = decoder(i);
+            size_t m = count(i);
+            for (size_t j = 0; j < m; ++j) {
+                t[j] = d.next();
+            }
+
+            return m;
+        }
+
+        compressed_sequence<Codec> sequence() const
+        {
+            return compressed_sequence<Codec>(*this);
+        }
+    };
+
+    // values of compressed storage, which must outlive the sequence
+    template<class Codec>
+    class compressed_sequence {
+    public:
+        typedef typename Codec::value_type value_type;
+    private:
+        const compressed<Codec>* c;
+        size_t i; // index of current value
+        typename Codec::decoder d;
+        value_type t;
+    public:
+        compressed_sequence(const compressed<Codec>& c)
+            : c(&c), i(0), d{}, t{}
+        {
+            seek(0);
+        }
+        bool operator==(const compressed_sequence& s) const
+        {
+            return c == s.c && i == s.i;
+        }
+        bool operator!=(const compressed_sequence& s) const
+        {
+            return !operator==(s);
+        }
+        operator bool() const
+        {
+            return i < c->size();
+        }
+        size_t size() const noexcept
+        {
+            return c->size() - i;
+        }
+        compressed_sequence& operator++()
+        {
+            if (*this && ++i < c->size()) {
+                if (i % c->block_size() == 0) {
+                    d = c->decoder(i / c->block_size());
+                }
+                t = d.next();
+            }
+
+            return *this;
+        }
+        value_type operator*() const
+        {
+            return t;
+        }
+        // skip whole blocks using their offsets
+        compressed_sequence& advance(size_t m)
+        {
+            seek(i + (std::min)(m, size()));
+
+            return *this;
+        }
+        // next m values into v, whole blocks are decoded directly
+        void fill(value_type* v, size_t m)
+        {
+            size_t B = c->block_size();
+
+            m = (std::min)(m, size());
+            while (m) {
+                if (i % B == 0 && m >= c->count(i / B)) {
+                    size_t k = c->decode(i / B, v);
+                    v += k;
+                    m -= k;
+                    seek(i + k);
+                }
+                else {
+                    *v++ = t;
+                    --m;
+                    operator++();
+                }
+            }
+        }
+    private:
+        void seek(size_t j)
+        {
+            i = j;
+            if (i < c->size()) {
+                size_t B = c->block_size();
+                d = c->decoder(i / B);
+                for (size_t k = i % B; k; --k) {
+                    d.next();
+                }
+                t = d.next();
+            }
+        }
+    };
+
+    template<class T>
+    using delta_compressed = compressed<codec::delta_varint<T>>;
+    using xor_compressed = compressed<codec::gorilla>;
+
+} // namespace fms::sequence
@@ -0,0 +1,106 @@
+// fms_sequence_continued_fraction.h - continued fractions using the modified Lentz algorithm
+#pragma once
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <type_traits>
+#include "fms_sequence.h"
+
+namespace fms::sequence {
+
+    // convergents of b[0] + a[0]/(b[1] + a[1]/(b[2] + ...))
+    // terminates after the convergent where f_n/f_{n-1} equals 1 to machine epsilon
+    // or when a or b is exhausted, like epsilon<S> does for series
+    // Press et al, "Numerical Recipes", section 5.2
+    template<class A, class B>
+    class lentz {
+    public:
+        typedef std::common_type_t<typename A::value_type, typename B::value_type> value_type;
+    private:
+        // replaces zero denominators
+        static constexpr value_type tiny = std::numeric_limits<value_type>::min() / std::numeric_limits<value_type>::epsilon();
+        A a;
+        B b;
+        value_type f, C, D;
+        bool converged, done;
+    public:
+        lentz(A a, B b)
+            : a(a), b(b), f(0), C(0), D(0), converged(false), done(!b)
+        {
+            if (!done) {
+                f = *this->b;
+                if (f == 0) {
+                    f = tiny;
+                }
+                C = f;
+                ++this->b;
+            }
+        }
+        bool operator==(const lentz& s) const
+        {
+            return a == s.a && b == s.b && done == s.done;
+        }
+        bool operator!=(const lentz& s) const
+        {
+            return !operator==(s);
+        }
+        operator bool() const
+        {
+            return !done;
+        }
+        lentz& operator++()
+        {
+            if (converged || !a || !b) {
+                done = true;
+            }
+            else if (!done) {
+                value_type aj = *a, bj = *b;
+                D = bj + aj * D;
+                if (D == 0) {
+                    D = tiny;
+                }
+                C = bj + aj / C;
+                if (C == 0) {
+                    C = tiny;
+                }
+                D = 1 / D;
+                value_type delta = C * D;
+                f *= delta;
+                converged = std::fabs(delta - 1) <= std::numeric_limits<value_type>::epsilon();
+                ++a;
+                ++b;
+            }
+
+            return *this;
+        }
+        value_type operator*() const
+        {
+            return f;
+        }
+    };
+
+    // b[0] + a[0]/(b[1] + a[1]/(b[2] + ...))
+    template<class A, class B>
+    inline auto continued_fraction(A a, B b)
+    {
+        lentz l(a, b);
+        auto f = *l;
+
+        while (++l) {
+            f = *l;
+        }
+
+        return f;
+    }
+
+    // y[i] = continued_fraction(a, b) where (a, b) = ab(x[i])
+    template<class F, class X, class Y>
+    inline void continued_fraction(F ab, const X* x, size_t n, Y* y)
+    {
+        for (size_t i = 0; i < n; ++i) {
+            auto [a, b] = ab(x[i]);
+            y[i] = continued_fraction(a, b);
+        }
+    }
+
+} // namespace fms::sequence
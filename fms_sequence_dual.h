@@ -0,0 +1,231 @@
+// fms_sequence_dual.h - forward mode automatic differentiation values for sequences
+#pragma once
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <type_traits>
+#include "fms_sequence.h"
+
+namespace fms::sequence {
+
+    // v + d[0] e_0 + ... + d[N-1] e_{N-1} where e_i e_j = 0
+    // comparisons use the value so epsilon terminates on the value part
+    template<class T = double, size_t N = 1>
+    class dual {
+        T v;
+        std::array<T, N> d;
+    public:
+        constexpr dual(T v = 0) noexcept
+            : v(v), d{}
+        { }
+        constexpr dual(T v, const std::array<T, N>& d) noexcept
+            : v(v), d(d)
+        { }
+        // independent variable in direction i
+        static constexpr dual variable(T v, size_t i = 0) noexcept
+        {
+            dual x(v);
+            x.d[i] = 1;
+
+            return x;
+        }
+
+        constexpr T value() const noexcept
+        {
+            return v;
+        }
+        // derivative in direction i
+        constexpr T operator[](size_t i) const noexcept
+        {
+            return d[i];
+        }
+        constexpr const std::array<T, N>& tangent() const noexcept
+        {
+            return d;
+        }
+
+        constexpr dual operator-() const noexcept
+        {
+            dual x(-v);
+            for (size_t i = 0; i < N; ++i) {
+                x.d[i] = -d[i];
+            }
+
+            return x;
+        }
+        constexpr dual& operator+=(const dual& x) noexcept
+        {
+            v += x.v;
+            for (size_t i = 0; i < N; ++i) {
+                d[i] += x.d[i];
+            }
+
+            return *this;
+        }
+        constexpr dual& operator-=(const dual& x) noexcept
+        {
+            v -= x.v;
+            for (size_t i = 0; i < N; ++i) {
+                d[i] -= x.d[i];
+            }
+
+            return *this;
+        }
+        // (u + du)(v + dv) = uv + u dv + v du
+        constexpr dual& operator*=(const dual& x) noexcept
+        {
+            for (size_t i = 0; i < N; ++i) {
+                d[i] = d[i] * x.v + v * x.d[i];
+            }
+            v *= x.v;
+
+            return *this;
+        }
+        // (u + du)/(v + dv) = u/v + (du - (u/v) dv)/v
+        constexpr dual& operator/=(const dual& x) noexcept
+        {
+            v /= x.v;
+            for (size_t i = 0; i < N; ++i) {
+                d[i] = (d[i] - v * x.d[i]) / x.v;
+            }
+
+            return *this;
+        }
+        // scalars only scale the tangent
+        constexpr dual& operator*=(T a) noexcept
+        {
+            v *= a;
+            for (size_t i = 0; i < N; ++i) {
+                d[i] *= a;
+            }
+
+            return *this;
+        }
+        constexpr dual& operator/=(T a) noexcept
+        {
+            v /= a;
+            for (size_t i = 0; i < N; ++i) {
+                d[i] /= a;
+            }
+
+            return *this;
+        }
+    };
+
+    template<class T, size_t N>
+    constexpr dual<T, N> operator+(dual<T, N> x, const dual<T, N>& y) noexcept
+    {
+        return x += y;
+    }
+    template<class T, size_t N>
+    constexpr dual<T, N> operator-(dual<T, N> x, const dual<T, N>& y) noexcept
+    {
+        return x -= y;
+    }
+    template<class T, size_t N>
+    constexpr dual<T, N> operator*(dual<T, N> x, const dual<T, N>& y) noexcept
+    {
+        return x *= y;
+    }
+    template<class T, size_t N>
+    constexpr dual<T, N> operator/(dual<T, N> x, const dual<T, N>& y) noexcept
+    {
+        return x /= y;
+    }
+
+    // mixed with scalars
+    template<class T, size_t N, class U, class = std::enable_if_t<std::is_arithmetic_v<U>>>
+    constexpr dual<T, N> operator+(dual<T, N> x, U a) noexcept
+    {
+        return x += dual<T, N>(static_cast<T>(a));
+    }
+    template<class T, size_t N, class U, class = std::enable_if_t<std::is_arithmetic_v<U>>>
+    constexpr dual<T, N> operator+(U a, dual<T, N> x) noexcept
+    {
+        return x += dual<T, N>(static_cast<T>(a));
+    }
+    template<class T, size_t N, class U, class = std::enable_if_t<std::is_arithmetic_v<U>>>
+    constexpr dual<T, N> operator-(dual<T, N> x, U a) noexcept
+    {
+        return x -= dual<T, N>(static_cast<T>(a));
+    }
+    template<class T, size_t N, class U, class = std::enable_if_t<std::is_arithmetic_v<U>>>
+    constexpr dual<T, N> operator-(U a, const dual<T, N>& x) noexcept
+    {
+        return dual<T, N>(static_cast<T>(a)) - x;
+    }
+    template<class T, size_t N, class U, class = std::enable_if_t<std::is_arithmetic_v<U>>>
+    constexpr dual<T, N> operator*(dual<T, N> x, U a) noexcept
+    {
+        return x *= static_cast<T>(a);
+    }
+    template<class T, size_t N, class U, class = std::enable_if_t<std::is_arithmetic_v<U>>>
+    constexpr dual<T, N> operator*(U a, dual<T, N> x) noexcept
+    {
+        return x *= static_cast<T>(a);
+    }
+    template<class T, size_t N, class U, class = std::enable_if_t<std::is_arithmetic_v<U>>>
+    constexpr dual<T, N> operator/(dual<T, N> x, U a) noexcept
+    {
+        return x /= static_cast<T>(a);
+    }
+    template<class T, size_t N, class U, class = std::enable_if_t<std::is_arithmetic_v<U>>>
+    constexpr dual<T, N> operator/(U a, const dual<T, N>& x) noexcept
+    {
+        return dual<T, N>(static_cast<T>(a)) / x;
+    }
+
+    // compare value parts
+    template<class T, size_t N>
+    constexpr bool operator==(const dual<T, N>& x, const dual<T, N>& y) noexcept
+    {
+        return x.value() == y.value();
+    }
+    template<class T, size_t N>
+    constexpr bool operator!=(const dual<T, N>& x, const dual<T, N>& y) noexcept
+    {
+        return x.value() != y.value();
+    }
+    template<class T, size_t N>
+    constexpr bool operator<(const dual<T, N>& x, const dual<T, N>& y) noexcept
+    {
+        return x.value() < y.value();
+    }
+    template<class T, size_t N>
+    constexpr bool operator>(const dual<T, N>& x, const dual<T, N>& y) noexcept
+    {
+        return y < x;
+    }
+    template<class T, size_t N, class U, class = std::enable_if_t<std::is_arithmetic_v<U>>>
+    constexpr bool operator==(const dual<T, N>& x, U a) noexcept
+    {
+        return x.value() == a;
+    }
+    template<class T, size_t N, class U, class = std::enable_if_t<std::is_arithmetic_v<U>>>
+    constexpr bool operator!=(const dual<T, N>& x, U a) noexcept
+    {
+        return x.value() != a;
+    }
+
+    // chain rule: f(v + dv) = f(v) + f'(v) dv
+    template<class T, size_t N>
+    inline dual<T, N> exp(const dual<T, N>& x)
+    {
+        T ev = std::exp(x.value());
+
+        return dual<T, N>(ev) + (x - x.value()) * ev;
+    }
+    template<class T, size_t N>
+    inline dual<T, N> log(const dual<T, N>& x)
+    {
+        return dual<T, N>(std::log(x.value())) + (x - x.value()) / x.value();
+    }
+    template<class T, size_t N>
+    inline dual<T, N> sqrt(const dual<T, N>& x)
+    {
+        T sv = std::sqrt(x.value());
+
+        return dual<T, N>(sv) + (x - x.value()) / (2 * sv);
+    }
+
+} // namespace fms::sequence
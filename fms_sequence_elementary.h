@@ -0,0 +1,415 @@
+// fms_sequence_elementary.h - elementary functions from series coefficient tables
+#pragma once
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <utility>
+#include "fms_sequence.h"
+
+namespace fms::sequence::elementary {
+
+    // first N terms of s, at compile time for constexpr sequences
+    template<size_t N, class S>
+    constexpr auto table(S s)
+    {
+        std::array<typename S::value_type, N> t{};
+        for (size_t i = 0; i < N && s; ++i, ++s) {
+            t[i] = *s;
+        }
+
+        return t;
+    }
+
+    namespace detail {
+
+        // scalar versions of the packed operations in fms_sequence_simd.h
+        // so each kernel is written once for double and for packs of doubles
+        using simd::bits;
+        using simd::value;
+        inline double select(bool m, double a, double b) noexcept
+        {
+            return m ? a : b;
+        }
+        inline double abs(double x) noexcept
+        {
+            return std::fabs(x);
+        }
+        inline bool any(bool m) noexcept
+        {
+            return m;
+        }
+
+        template<size_t N, class V, size_t... I>
+        inline V horner(const std::array<double, N>& c, V x, std::index_sequence<I...>) noexcept
+        {
+            V p = c[N - 1];
+            ((p = p * x + c[N - 2 - I]), ...);
+
+            return p;
+        }
+        // c[0] + c[1] x + ... + c[N - 1] x^{N - 1}
+        template<size_t N, class V>
+        inline V horner(const std::array<double, N>& c, V x) noexcept
+        {
+            return horner(c, x, std::make_index_sequence<N - 1>{});
+        }
+
+        // c[B] + c[B + 2] y + c[B + 4] y^2 + ... + c[B + 2(M - 1)] y^{M - 1}
+        template<size_t B, size_t M, size_t N, class V, size_t... I>
+        inline V horner2(const std::array<double, N>& c, V y, std::index_sequence<I...>) noexcept
+        {
+            V p = c[B + 2 * (M - 1)];
+            ((p = p * y + c[B + 2 * (M - 2 - I)]), ...);
+
+            return p;
+        }
+        // even(x^2) + x odd(x^2), two independent chains for long polynomials
+        // whose evaluation is bound by the latency of the Horner chain
+        template<size_t N, class V>
+        inline V horner2(const std::array<double, N>& c, V x) noexcept
+        {
+            constexpr size_t E = (N + 1) / 2, O = N / 2;
+            V y = x * x;
+
+            return horner2<0, E>(c, y, std::make_index_sequence<E - 1>{}) + x * horner2<1, O>(c, y, std::make_index_sequence<O - 1>{});
+        }
+
+        // Taylor coefficients of the Mills ratio R(z) = (1 - Phi(z))/phi(z) about z0
+        // R' = z R - 1 gives (n + 1) r_{n+1} = z0 r_n + r_{n-1} with r_{-1} = -1
+        // carried in long double since the recurrence loses a few bits
+        class mills {
+            long double z0, r0, r1; // r_{n-1}, r_n
+            size_t n;
+        public:
+            using value_type = long double;
+
+            // r_0 = R(z0) from Laplace's continued fraction 1/(z + 1/(z + 2/(z + ...))) evaluated backwards
+            constexpr mills(long double z0, size_t depth = 4000)
+                : z0(z0), r0(-1), r1(0), n(0)
+            {
+                long double t = z0;
+                for (size_t k = depth; k > 0; --k) {
+                    t = z0 + k / t;
+                }
+                r1 = 1 / t;
+            }
+
+            constexpr bool operator==(const mills& m) const
+            {
+                return z0 == m.z0 && r0 == m.r0 && r1 == m.r1 && n == m.n;
+            }
+            constexpr bool operator!=(const mills& m) const
+            {
+                return !operator==(m);
+            }
+
+            constexpr explicit operator bool() const
+            {
+                return true;
+            }
+            constexpr value_type operator*() const
+            {
+                return r1;
+            }
+            constexpr mills& operator++()
+            {
+                long double r = (z0 * r1 + r0) / (n + 1);
+                r0 = r1;
+                r1 = r;
+                ++n;
+
+                return *this;
+            }
+        };
+
+        // 1/n!, n = 0, 1, ...
+        constexpr auto exp_c = table<14>(power_factorial<double>(1));
+        // 1/(n + 1)!, n = 0, 1, ...
+        constexpr auto expm1_c = table<14>(power_factorial<double>(1, 1, 1));
+        // 1/(2n + 1), n = 0, 1, ...
+        constexpr auto atanh_c = [] {
+            auto t = table<12>(linear<double>(1, 2));
+            for (auto& ti : t) {
+                ti = 1 / ti;
+            }
+            return t;
+        }();
+        // R(2 + t)/sqrt(2 pi) = sum r_n t^n/sqrt(2 pi) for |t| <= 2, scaled before rounding
+        constexpr auto mills_c = [] {
+            auto r = table<40>(mills(2));
+            std::array<double, 40> c{};
+            for (size_t n = 0; n < c.size(); ++n) {
+                c[n] = static_cast<double>(r[n] / 2.506628274631000502415765284811045253L);
+            }
+            return c;
+        }();
+
+        constexpr double log2e = 1.4426950408889634;
+        constexpr double ln2_hi = 0x1.62e42fee00000p-1; // low bits zero so k ln2_hi is exact
+        constexpr double ln2_lo = 0x1.a39ef35793c76p-33;
+        constexpr double shift = 0x1.8p52; // x + shift - shift rounds x to an integer
+
+        // x = k log(2) + r, |r| <= log(2)/2, for -746 <= x <= 710
+        // 2^k = s1 s2 is split so subnormal and near overflow results are scaled exactly
+        template<class V>
+        inline V reduce(V x, V& s1, V& s2) noexcept
+        {
+            V k = (x * log2e + shift) - shift;
+            V k1 = (k * 0.5 + shift) - shift, k2 = k - k1;
+            // the low bits of shift + k + 1023 are the biased exponent of 2^k
+            s1 = value(bits(k1 + (shift + 1023)) << 52);
+            s2 = value(bits(k2 + (shift + 1023)) << 52);
+
+            return (x - k * ln2_hi) - k * ln2_lo;
+        }
+
+        // Laplace's continued fraction 1/(z + 1/(z + 2/(z + ... K/z))) for the Mills ratio
+        // evaluated from the tail as t_k = z + k/t_{k+1} = p_k/q_k, p_k = z p_{k+1} + k q_{k+1}, q_k = p_{k+1}
+        // t -> z + k/t contracts so rounding errors are damped instead of accumulating as in the forward recurrence
+        template<class V, size_t... I>
+        inline V laplace(V z, std::index_sequence<I...>) noexcept
+        {
+            constexpr double K = sizeof...(I);
+            V p = z, q = 1;
+            auto step = [&](double k) {
+                V p_ = z * p + k * q;
+                q = p;
+                p = p_;
+            };
+            (step(K - I), ...);
+
+            return q / p;
+        }
+
+        // kernels for double and packed doubles, both sides of each case
+        // are computed and the result selected lane by lane
+        template<class V>
+        inline V exp(V x) noexcept
+        {
+            V s1, s2;
+            V r = reduce(x, s1, s2);
+            V y = horner(exp_c, r) * s1 * s2;
+
+            y = select(x > 710, V(std::numeric_limits<double>::infinity()), y);
+
+            return select(x < -746, V(0), y);
+        }
+
+        template<class V>
+        inline V expm1(V x) noexcept
+        {
+            V s1, s2;
+            V r = reduce(x, s1, s2);
+            V q = r * horner(expm1_c, r); // exp(r) - 1
+
+            // 2^k (q + 1) - 1 = s2 (s1 q + s1 - 1/s2)
+            V y = (s1 * q + (s1 - 1 / s2)) * s2;
+
+            y = select(x > 710, V(std::numeric_limits<double>::infinity()), y);
+
+            return select(x < -746, V(-1), y);
+        }
+
+        template<class V>
+        inline V log(V x) noexcept
+        {
+            auto sub = x < std::numeric_limits<double>::min();
+            V xs = select(sub, x * 0x1p54, x);
+            auto u = bits(xs);
+            // biased exponent as a double by placing it in the mantissa of 2^52
+            V e = value(((u >> 52) & 0x7FF) | bits(0x1p52)) - 0x1p52 - select(sub, V(1023 + 54), V(1023));
+            V m = value((u & 0x000FFFFFFFFFFFFFull) | bits(1.));
+            auto hi = m > 1.4142135623730951;
+            m = select(hi, m * 0.5, m);
+            V k = select(hi, e + 1, e);
+
+            V s = (m - 1) / (m + 1);
+            V y = k * ln2_hi + (2 * s * horner(atanh_c, s * s) + k * ln2_lo);
+
+            y = select(x < 0, V(std::numeric_limits<double>::quiet_NaN()), y);
+            y = select(x == 0, V(-std::numeric_limits<double>::infinity()), y);
+            y = select(x == std::numeric_limits<double>::infinity(), x, y);
+
+            return select(x != x, x, y);
+        }
+
+        template<class V>
+        inline V normal_cdf(V x) noexcept
+        {
+            constexpr double sqrt2pi = 2.5066282746310002;
+            V z = abs(x);
+            z = select(z < 40, z, V(40)); // phi underflows before 40
+
+            // z^2 = hi + lo exactly by splitting z into 26 bit halves
+            V c = 134217729. * z;
+            V zh = c - (c - z), zl = z - zh;
+            V hi = z * z;
+            V lo = ((zh * zh - hi) + 2 * zh * zl) + zl * zl;
+            V e = exp(-0.5 * hi) * (1 - 0.5 * lo); // sqrt(2 pi) phi(z)
+
+            // R/sqrt(2 pi) from the Taylor series of the Mills ratio below 4 and the continued fraction beyond,
+            // which needs 36 terms at 4 but only 16 from 8, only the cases present in a pack are evaluated
+            auto small = z < 4, large = z >= 8;
+            V r = any(small) ? horner2(mills_c, z - 2) : V(0);
+            r = any((z >= 4) & (z < 8)) ? select(small, r, laplace(z, std::make_index_sequence<36>{}) / sqrt2pi) : r;
+            r = any(large) ? select(large, laplace(z, std::make_index_sequence<16>{}) / sqrt2pi, r) : r;
+
+            V q = e * r; // 1 - Phi(|x|)
+            q = select(x < 0, q, 1 - q);
+
+            return select(x != x, x, q);
+        }
+
+        // erfc(u)/2 for u = -x/sqrt(2), with erfc(uh) corrected to first order for the error
+        // d = u - uh of the rounded uh using erfc'(u) = -2/sqrt(pi) exp(-u^2) ~ -(2u + 1/u) erfc(u) for u > 1
+        // without the correction the relative error grows like u^2 in the lower tail
+        inline double normal_cdf_erfc(double x) noexcept
+        {
+            constexpr double r = 0.7071067811865476, r_lo = -4.833646656726457e-17; // 1/sqrt(2) = r + r_lo
+            double a = -x, uh = a * r;
+            // exact error of a r by splitting both into 26 bit halves
+            double c = 134217729. * a, ah = c - (c - a), al = a - ah;
+            double cr = 134217729. * r, rh = cr - (cr - r), rl = r - rh;
+            double d = (((ah * rh - uh) + ah * rl + al * rh) + al * rl) + a * r_lo;
+            double e = std::erfc(uh) / 2;
+
+            return uh > 1 && uh < 27 ? e * (1 - (2 * uh + 1 / uh) * d) : e;
+        }
+
+        // y[i] = f(x[i]) a pack at a time where available, then one at a time
+        template<class F>
+        inline void map(const double* x, size_t n, double* y, F f) noexcept
+        {
+#ifdef FMS_SEQUENCE_F64
+            using V = simd::f64;
+            for (; n >= V::size; n -= V::size, x += V::size, y += V::size) {
+                f(V::load(x)).store(y);
+            }
+#endif
+            for (size_t i = 0; i < n; ++i) {
+                y[i] = f(x[i]);
+            }
+        }
+
+    } // namespace detail
+
+    inline double exp(double x) noexcept
+    {
+        return detail::exp(x);
+    }
+
+    // exp(x) - 1 accurate near 0
+    inline double expm1(double x) noexcept
+    {
+        return detail::expm1(x);
+    }
+
+    // x = 2^e m, sqrt(1/2) < m <= sqrt(2), log(m) = 2 atanh((m - 1)/(m + 1))
+    inline double log(double x) noexcept
+    {
+        return detail::log(x);
+    }
+
+    // standard normal cumulative distribution
+    // 1 - Phi(|x|) = phi(|x|) R(|x|) for the Mills ratio R so the lower tail keeps its relative accuracy
+    // R is a Taylor series about 2 for |x| < 4 and 1/t for Laplace's continued fraction
+    // t = |x| + 1/(|x| + 2/(|x| + ...)) beyond, phi uses |x|^2 split exactly in two doubles
+    inline double normal_cdf(double x) noexcept
+    {
+        return detail::normal_cdf(x);
+    }
+
+    // y[i] = f(x[i]) using packed doubles, SSE2 or AVX2 if enabled
+    inline void exp(const double* x, size_t n, double* y) noexcept
+    {
+        detail::map(x, n, y, [](auto x) { return detail::exp(x); });
+    }
+    inline void expm1(const double* x, size_t n, double* y) noexcept
+    {
+        detail::map(x, n, y, [](auto x) { return detail::expm1(x); });
+    }
+    // two SSE2 lanes do not beat libm for log and normal_cdf, so without AVX2 they loop over libm
+    inline void log(const double* x, size_t n, double* y) noexcept
+    {
+#ifdef FMS_SEQUENCE_AVX2
+        detail::map(x, n, y, [](auto x) { return detail::log(x); });
+#else
+        for (size_t i = 0; i < n; ++i) {
+            y[i] = std::log(x[i]);
+        }
+#endif
+    }
+    inline void normal_cdf(const double* x, size_t n, double* y) noexcept
+    {
+#ifdef FMS_SEQUENCE_AVX2
+        detail::map(x, n, y, [](auto x) { return detail::normal_cdf(x); });
+#else
+        for (size_t i = 0; i < n; ++i) {
+            y[i] = detail::normal_cdf_erfc(x[i]);
+        }
+#endif
+    }
+
+    namespace detail {
+
+        // kernel f(x, n, y) over s, contiguous doubles are passed through and
+        // other sequences are buffered in blocks, returns the number of values written
+        template<class S, class F>
+        inline size_t batch(S s, double* y, F f)
+        {
+            constexpr bool is_double = std::is_same_v<std::remove_const_t<typename S::value_type>, double>;
+
+            if constexpr (is_double && is_pointer_array_v<S>) {
+                f(s.base().data(), s.size(), y);
+
+                return s.size();
+            }
+            else if constexpr (is_double && is_contiguous_v<S>) {
+                return batch(array(s), y, f);
+            }
+            else {
+                constexpr size_t B = 256;
+                double x[B];
+                size_t n = 0;
+
+                while (s) {
+                    size_t m = 0;
+                    for (; m < B && s; ++m, ++s) {
+                        x[m] = static_cast<double>(*s);
+                    }
+                    f(x, m, y + n);
+                    n += m;
+                }
+
+                return n;
+            }
+        }
+
+    } // namespace detail
+
+    // y[i] = f(s[i]) for finite sequences s
+    template<class S, class = std::enable_if_t<is_sequence_v<S>>>
+    inline size_t exp(S s, double* y)
+    {
+        return detail::batch(s, y, [](const double* x, size_t n, double* y) { exp(x, n, y); });
+    }
+    template<class S, class = std::enable_if_t<is_sequence_v<S>>>
+    inline size_t expm1(S s, double* y)
+    {
+        return detail::batch(s, y, [](const double* x, size_t n, double* y) { expm1(x, n, y); });
+    }
+    template<class S, class = std::enable_if_t<is_sequence_v<S>>>
+    inline size_t log(S s, double* y)
+    {
+        return detail::batch(s, y, [](const double* x, size_t n, double* y) { log(x, n, y); });
+    }
+    template<class S, class = std::enable_if_t<is_sequence_v<S>>>
+    inline size_t normal_cdf(S s, double* y)
+    {
+        return detail::batch(s, y, [](const double* x, size_t n, double* y) { normal_cdf(x, n, y); });
+    }
+
+} // namespace fms::sequence::elementary
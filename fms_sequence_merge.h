@@ -0,0 +1,176 @@
+// fms_sequence_merge.h - lazy merge of sorted sequences
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+#include "fms_sequence.h"
+
+namespace fms::sequence {
+
+    // merge a compile time number of sorted sequences
+    // each step selects the first of the K heads, ties go to the earlier sequence
+    template<class Cmp, class... S>
+    class merge {
+        static constexpr size_t N = sizeof...(S);
+        Cmp cmp;
+        std::tuple<S...> s;
+        size_t i; // index of sequence holding the current element, N if none
+    public:
+        typedef std::common_type_t<typename S::value_type...> value_type;
+        merge(Cmp cmp, S... ss)
+            : cmp(cmp), s(ss...), i(N)
+        {
+            select();
+        }
+        bool operator==(const merge& m) const
+        {
+            return i == m.i && s == m.s;
+        }
+        bool operator!=(const merge& m) const
+        {
+            return !operator==(m);
+        }
+        operator bool() const
+        {
+            return i != N;
+        }
+        // sized if all sequences are sized
+        template<class T = std::tuple<S...>>
+        auto size() const noexcept -> decltype(size_sum(std::declval<const T&>()))
+        {
+            return size_sum(s);
+        }
+        merge& operator++()
+        {
+            if (*this) {
+                increment();
+                select();
+            }
+
+            return *this;
+        }
+        value_type operator*() const
+        {
+            return star();
+        }
+    private:
+        void increment()
+        {
+            apply_at(s, i, [](auto& si) { ++si; });
+        }
+        value_type star() const
+        {
+            value_type t{};
+            apply_at(s, i, [&t](const auto& si) { t = *si; });
+
+            return t;
+        }
+        void select()
+        {
+            select(std::make_index_sequence<N>{});
+        }
+        // unrolled scan keeping the best head in registers, no branches on the data
+        template<size_t... I>
+        void select(std::index_sequence<I...>)
+        {
+            size_t j = N;
+            value_type v{};
+            auto scan = [&](size_t k, const auto& sk) {
+                bool take = sk && (j == N || cmp(*sk, v));
+                j = take ? k : j;
+                v = take ? static_cast<value_type>(*sk) : v;
+            };
+            (scan(I, std::get<I>(s)), ...);
+
+            i = j;
+        }
+    };
+
+    // merge a run time number of sorted sequences using a tournament tree
+    // each step replays one leaf to root path, O(log K) comparisons
+    template<class Cmp, class S>
+    class merge_tree {
+        Cmp cmp;
+        std::vector<S> s;
+        std::vector<size_t> w; // w[k] is the winning leaf below node k, leaves at w[K + j]
+        size_t n;              // remaining elements if S is sized
+    public:
+        typedef typename S::value_type value_type;
+        merge_tree(Cmp cmp, std::vector<S> ss)
+            : cmp(cmp), s(std::move(ss)), w(2 * (std::max)(s.size(), size_t(1)), s.size()), n(0)
+        {
+            size_t K = s.size();
+            for (size_t j = 0; j < K; ++j) {
+                w[K + j] = j;
+                if constexpr (is_sized_v<S>) {
+                    n = size_add(n, s[j].size());
+                }
+            }
+            for (size_t k = K; k-- > 1; ) {
+                w[k] = play(w[2 * k], w[2 * k + 1]);
+            }
+            if (K == 1) {
+                w[1] = s[0] ? 0 : K;
+            }
+        }
+        bool operator==(const merge_tree& m) const
+        {
+            return s == m.s;
+        }
+        bool operator!=(const merge_tree& m) const
+        {
+            return !operator==(m);
+        }
+        operator bool() const
+        {
+            return w[1] != s.size();
+        }
+        template<class S_ = S, class = std::enable_if_t<is_sized_v<S_>>>
+        size_t size() const noexcept
+        {
+            return n;
+        }
+        merge_tree& operator++()
+        {
+            if (*this) {
+                size_t j = w[1];
+                ++s[j];
+                if constexpr (is_sized_v<S>) {
+                    if (n != infinite) {
+                        --n;
+                    }
+                }
+                size_t K = s.size();
+                if (K == 1) {
+                    w[1] = s[0] ? 0 : K;
+                }
+                for (size_t k = (K + j) / 2; k >= 1; k /= 2) {
+                    w[k] = play(w[2 * k], w[2 * k + 1]);
+                }
+            }
+
+            return *this;
+        }
+        value_type operator*() const
+        {
+            return *s[w[1]];
+        }
+    private:
+        // winner of leaves a and b, K if both are exhausted
+        size_t play(size_t a, size_t b) const
+        {
+            size_t K = s.size();
+            if (a == K || !s[a]) {
+                return b == K || !s[b] ? K : b;
+            }
+            if (b == K || !s[b]) {
+                return a;
+            }
+
+            return cmp(*s[b], *s[a]) || (!cmp(*s[a], *s[b]) && b < a) ? b : a;
+        }
+    };
+
+} // namespace fms::sequence
@@ -0,0 +1,197 @@
+// fms_sequence_perf.h - hardware performance counters around sequence algorithms
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include "fms_sequence.h"
+
+#if defined(__linux__)
+#define FMS_SEQUENCE_PERF_EVENT
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace fms::sequence::perf {
+
+    enum event { cycles, instructions, branch_misses, cache_misses, events };
+
+    inline const char* name(event e)
+    {
+        static const char* n[events] = { "cycles", "instructions", "branch-misses", "cache-misses" };
+
+        return n[e];
+    }
+
+    // counts over a measured call, valid(e) is false if e could not be counted
+    struct sample {
+        uint64_t count[events] = {};
+        bool counted[events] = {};
+        double seconds = 0;
+        size_t n = 0; // elements processed, 0 if unknown
+
+        bool valid(event e) const noexcept
+        {
+            return counted[e];
+        }
+        // per element figures, or per call if n is 0
+        double per_element(event e) const noexcept
+        {
+            return static_cast<double>(count[e]) / (n ? n : 1);
+        }
+        double nanoseconds_per_element() const noexcept
+        {
+            return 1e9 * seconds / (n ? n : 1);
+        }
+        // instructions per cycle
+        double ipc() const noexcept
+        {
+            return count[cycles] ? static_cast<double>(count[instructions]) / count[cycles] : 0;
+        }
+    };
+
+    // user space counters for the calling thread
+    // each event is opened separately so a missing one does not disable the others
+    // and counts are scaled by enabled/running time if the kernel multiplexes them
+    class counters {
+        int fd[events];
+    public:
+        counters() noexcept
+        {
+            for (int e = 0; e < events; ++e) {
+                fd[e] = open(static_cast<event>(e));
+            }
+        }
+        counters(const counters&) = delete;
+        counters& operator=(const counters&) = delete;
+        ~counters()
+        {
+#ifdef FMS_SEQUENCE_PERF_EVENT
+            for (int e = 0; e < events; ++e) {
+                if (fd[e] != -1) {
+                    ::close(fd[e]);
+                }
+            }
+#endif
+        }
+
+        // true if any event can be counted
+        bool available() const noexcept
+        {
+            for (int e = 0; e < events; ++e) {
+                if (fd[e] != -1) {
+                    return true;
+                }
+            }
+
+            return false;
+        }
+        bool available(event e) const noexcept
+        {
+            return fd[e] != -1;
+        }
+
+        void start() noexcept
+        {
+#ifdef FMS_SEQUENCE_PERF_EVENT
+            for (int e = 0; e < events; ++e) {
+                if (fd[e] != -1) {
+                    ioctl(fd[e], PERF_EVENT_IOC_RESET, 0);
+                    ioctl(fd[e], PERF_EVENT_IOC_ENABLE, 0);
+                }
+            }
+#endif
+        }
+        // counts since start()
+        sample stop() noexcept
+        {
+            sample s;
+
+#ifdef FMS_SEQUENCE_PERF_EVENT
+            for (int e = 0; e < events; ++e) {
+                if (fd[e] != -1) {
+                    ioctl(fd[e], PERF_EVENT_IOC_DISABLE, 0);
+                }
+            }
+            for (int e = 0; e < events; ++e) {
+                uint64_t v[3]; // value, time enabled, time running
+                if (fd[e] != -1 && ::read(fd[e], v, sizeof v) == sizeof v && v[2] != 0) {
+                    s.count[e] = v[2] < v[1] ? static_cast<uint64_t>(static_cast<double>(v[0]) * v[1] / v[2]) : v[0];
+                    s.counted[e] = true;
+                }
+            }
+#endif
+
+            return s;
+        }
+    private:
+        static int open([[maybe_unused]] event e) noexcept
+        {
+#ifdef FMS_SEQUENCE_PERF_EVENT
+            static const uint64_t config[events] = {
+                PERF_COUNT_HW_CPU_CYCLES,
+                PERF_COUNT_HW_INSTRUCTIONS,
+                PERF_COUNT_HW_BRANCH_MISSES,
+                PERF_COUNT_HW_CACHE_MISSES,
+            };
+            perf_event_attr attr{};
+            attr.size = sizeof attr;
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = config[e];
+            attr.disabled = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+            // this thread on any cpu, fails if there is no PMU or perf_event_paranoid forbids it
+            long fd = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+
+            return fd < 0 ? -1 : static_cast<int>(fd);
+#else
+            return -1;
+#endif
+        }
+    };
+
+    // counters around repeat calls of f processing n elements each
+    // wall clock time is always measured, the counters only where available
+    template<class F>
+    inline sample measure(F&& f, size_t n = 0, size_t repeat = 1)
+    {
+        counters c;
+
+        auto t0 = std::chrono::steady_clock::now();
+        c.start();
+        for (size_t i = 0; i < repeat; ++i) {
+            f();
+        }
+        sample s = c.stop();
+        std::chrono::duration<double> dt = std::chrono::steady_clock::now() - t0;
+
+        s.seconds = dt.count();
+        s.n = n * repeat;
+
+        return s;
+    }
+
+    // one line of per element figures, n/a for events that could not be counted
+    inline void print(std::FILE* out, const char* label, const sample& s)
+    {
+        std::fprintf(out, "%-32s %10.3f ns", label, s.nanoseconds_per_element());
+        for (int e = 0; e < events; ++e) {
+            if (s.valid(static_cast<event>(e))) {
+                std::fprintf(out, " %10.3f %s", s.per_element(static_cast<event>(e)), name(static_cast<event>(e)));
+            }
+            else {
+                std::fprintf(out, " %10s %s", "n/a", name(static_cast<event>(e)));
+            }
+        }
+        if (s.valid(cycles) && s.valid(instructions)) {
+            std::fprintf(out, " %6.2f IPC", s.ipc());
+        }
+        std::fprintf(out, "\n");
+    }
+
+} // namespace fms::sequence::perf
@@ -0,0 +1,217 @@
+// fms_sequence_random.h - counter based random number sequences
+// Philox4x32-10 from Salmon et al, "Parallel Random Numbers: As Easy as 1, 2, 3"
+#pragma once
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include "fms_sequence.h"
+
+namespace fms::sequence {
+
+    namespace random {
+
+        using ctr_type = std::array<uint32_t, 4>;
+        using key_type = std::array<uint32_t, 2>;
+
+        constexpr uint32_t philox_M0 = 0xD2511F53;
+        constexpr uint32_t philox_M1 = 0xCD9E8D57;
+        constexpr uint32_t philox_W0 = 0x9E3779B9;
+        constexpr uint32_t philox_W1 = 0xBB67AE85;
+
+        // bijection of the counter determined by the key
+        inline ctr_type philox(ctr_type c, key_type k) noexcept
+        {
+            for (int r = 0; r < 10; ++r) {
+                uint64_t p0 = uint64_t(philox_M0) * c[0];
+                uint64_t p1 = uint64_t(philox_M1) * c[2];
+                c = { uint32_t(p1 >> 32) ^ c[1] ^ k[0], uint32_t(p1),
+                      uint32_t(p0 >> 32) ^ c[3] ^ k[1], uint32_t(p0) };
+                k[0] += philox_W0;
+                k[1] += philox_W1;
+            }
+
+            return c;
+        }
+
+        // B independent counters at once, laid out so the rounds vectorize
+        template<size_t B>
+        inline void philox(uint32_t (&c)[4][B], key_type k) noexcept
+        {
+            for (int r = 0; r < 10; ++r) {
+                for (size_t j = 0; j < B; ++j) {
+                    uint64_t p0 = uint64_t(philox_M0) * c[0][j];
+                    uint64_t p1 = uint64_t(philox_M1) * c[2][j];
+                    uint32_t c1 = c[1][j], c3 = c[3][j];
+                    c[0][j] = uint32_t(p1 >> 32) ^ c1 ^ k[0];
+                    c[1][j] = uint32_t(p1);
+                    c[2][j] = uint32_t(p0 >> 32) ^ c3 ^ k[1];
+                    c[3][j] = uint32_t(p0);
+                }
+                k[0] += philox_W0;
+                k[1] += philox_W1;
+            }
+        }
+
+        // uniform in the open interval (0, 1) from 64 random bits
+        inline double to_uniform(uint32_t hi, uint32_t lo) noexcept
+        {
+            uint64_t x = ((uint64_t(hi) << 32) | lo) >> 11;
+
+            return (x + 0.5) * 0x1p-53;
+        }
+
+        // uniform float in the open interval (0, 1) from 23 random bits
+        // rounding the double from to_uniform could give 1, and k + 1/2 is exact in a float only for k < 2^23
+        inline float to_uniform(uint32_t x) noexcept
+        {
+            return ((x >> 9) + 0.5f) * 0x1p-23f;
+        }
+
+        // two uniforms from one Philox block
+        struct uniform_map {
+            template<class T>
+            void operator()(uint32_t x0, uint32_t x1, uint32_t x2, uint32_t x3, T* t) const noexcept
+            {
+                if constexpr (std::is_same_v<T, float>) {
+                    t[0] = to_uniform(x0);
+                    t[1] = to_uniform(x2);
+                }
+                else {
+                    t[0] = static_cast<T>(to_uniform(x0, x1));
+                    t[1] = static_cast<T>(to_uniform(x2, x3));
+                }
+            }
+        };
+
+        // two standard normals from one Philox block using Box-Muller
+        struct normal_map {
+            template<class T>
+            void operator()(uint32_t x0, uint32_t x1, uint32_t x2, uint32_t x3, T* t) const noexcept
+            {
+                constexpr double two_pi = 6.283185307179586476925;
+                double r = std::sqrt(-2 * std::log(to_uniform(x0, x1)));
+                double theta = two_pi * to_uniform(x2, x3);
+                t[0] = static_cast<T>(r * std::cos(theta));
+                t[1] = static_cast<T>(r * std::sin(theta));
+            }
+        };
+
+    } // namespace random
+
+    // element n of stream s with seed k is lane n%2 of philox({n/2, s}, k)
+    template<class T, class Map>
+    class counter_based {
+        random::key_type key;
+        uint64_t stream;
+        uint64_t n;    // index of current element
+        T t[2];        // current block
+    public:
+        typedef T value_type;
+        counter_based(uint64_t seed = 0, uint64_t stream = 0) noexcept
+            : key{ uint32_t(seed), uint32_t(seed >> 32) }, stream(stream), n(0)
+        {
+            block();
+        }
+        bool operator==(const counter_based& s) const
+        {
+            return key == s.key && stream == s.stream && n == s.n;
+        }
+        bool operator!=(const counter_based& s) const
+        {
+            return !operator==(s);
+        }
+        operator bool() const
+        {
+            return true;
+        }
+        size_t size() const noexcept
+        {
+            return infinite;
+        }
+        counter_based& operator++()
+        {
+            if (++n % 2 == 0) {
+                block();
+            }
+
+            return *this;
+        }
+        value_type operator*() const
+        {
+            return t[n % 2];
+        }
+        // O(1) jump ahead
+        counter_based& advance(size_t m)
+        {
+            n += m;
+            block();
+
+            return *this;
+        }
+        uint64_t index() const noexcept
+        {
+            return n;
+        }
+        // independent sequence with the same seed
+        counter_based substream(uint64_t i) const noexcept
+        {
+            counter_based s(*this);
+            s.stream = i;
+            s.n = 0;
+            s.block();
+
+            return s;
+        }
+        // next m elements into v, leaving the sequence after them
+        void fill(T* v, size_t m)
+        {
+            constexpr size_t B = 8; // blocks per batch
+            Map map;
+
+            // finish a partially used block
+            if (m && n % 2) {
+                *v++ = t[1];
+                --m;
+                ++n;
+            }
+            while (m >= 2 * B) {
+                uint32_t c[4][B];
+                for (size_t j = 0; j < B; ++j) {
+                    uint64_t b = n / 2 + j;
+                    c[0][j] = uint32_t(b);
+                    c[1][j] = uint32_t(b >> 32);
+                    c[2][j] = uint32_t(stream);
+                    c[3][j] = uint32_t(stream >> 32);
+                }
+                random::philox(c, key);
+                for (size_t j = 0; j < B; ++j) {
+                    map(c[0][j], c[1][j], c[2][j], c[3][j], v + 2 * j);
+                }
+                v += 2 * B;
+                m -= 2 * B;
+                n += 2 * B;
+            }
+            block();
+            while (m--) {
+                *v++ = **this;
+                operator++();
+            }
+        }
+    private:
+        void block() noexcept
+        {
+            uint64_t b = n / 2;
+            auto x = random::philox({ uint32_t(b), uint32_t(b >> 32), uint32_t(stream), uint32_t(stream >> 32) }, key);
+            Map{}(x[0], x[1], x[2], x[3], t);
+        }
+    };
+
+    // uniform on (0, 1)
+    template<class T = double>
+    using uniform = counter_based<T, random::uniform_map>;
+
+    // standard normal
+    template<class T = double>
+    using normal = counter_based<T, random::normal_map>;
+
+} // namespace fms::sequence
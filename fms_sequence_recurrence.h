@@ -0,0 +1,122 @@
+// fms_sequence_recurrence.h - linear recurrences with jump ahead
+#pragma once
+#include <array>
+#include <cstddef>
+#include "fms_sequence.h"
+
+namespace fms::sequence {
+
+    // x[n + K] = c[0] x[n + K - 1] + c[1] x[n + K - 2] + ... + c[K - 1] x[n]
+    // starting from x[0], ..., x[K - 1]
+    template<class T, size_t K>
+    class recurrence {
+        using vector = std::array<T, K>;
+        using matrix = std::array<vector, K>;
+        vector c;
+        vector x; // x[n], ..., x[n + K - 1]
+    public:
+        typedef T value_type;
+        recurrence(const vector& c, const vector& x0) noexcept
+            : c(c), x(x0)
+        { }
+        bool operator==(const recurrence& s) const
+        {
+            return c == s.c && x == s.x;
+        }
+        bool operator!=(const recurrence& s) const
+        {
+            return !operator==(s);
+        }
+        operator bool() const
+        {
+            return true;
+        }
+        size_t size() const noexcept
+        {
+            return infinite;
+        }
+        recurrence& operator++()
+        {
+            T y = 0;
+            for (size_t j = 0; j < K; ++j) {
+                y += c[j] * x[K - 1 - j];
+            }
+            for (size_t j = 0; j + 1 < K; ++j) {
+                x[j] = x[j + 1];
+            }
+            x[K - 1] = y;
+
+            return *this;
+        }
+        value_type operator*() const
+        {
+            return x[0];
+        }
+        // x[n + m] using O(K^3 log m) operations, stepping when that is cheaper
+        recurrence& advance(size_t m)
+        {
+            size_t lg = 0;
+            for (size_t k = m; k; k >>= 1) {
+                ++lg;
+            }
+            if (m <= K * K * lg) {
+                while (m--) {
+                    operator++();
+                }
+            }
+            else {
+                // x <- M^m x by repeated squaring
+                matrix P = companion();
+                for (; m; m >>= 1) {
+                    if (m & 1) {
+                        x = multiply(P, x);
+                    }
+                    if (m > 1) {
+                        P = multiply(P, P);
+                    }
+                }
+            }
+
+            return *this;
+        }
+    private:
+        // M (x[n], ..., x[n + K - 1]) = (x[n + 1], ..., x[n + K])
+        matrix companion() const
+        {
+            matrix M{};
+            for (size_t i = 0; i + 1 < K; ++i) {
+                M[i][i + 1] = 1;
+            }
+            for (size_t j = 0; j < K; ++j) {
+                M[K - 1][j] = c[K - 1 - j];
+            }
+
+            return M;
+        }
+        static vector multiply(const matrix& A, const vector& v)
+        {
+            vector w{};
+            for (size_t i = 0; i < K; ++i) {
+                for (size_t j = 0; j < K; ++j) {
+                    w[i] += A[i][j] * v[j];
+                }
+            }
+
+            return w;
+        }
+        static matrix multiply(const matrix& A, const matrix& B)
+        {
+            matrix C{};
+            for (size_t i = 0; i < K; ++i) {
+                for (size_t k = 0; k < K; ++k) {
+                    for (size_t j = 0; j < K; ++j) {
+                        C[i][j] += A[i][k] * B[k][j];
+                    }
+                }
+            }
+
+            return C;
+        }
+    };
+
+} // namespace fms::sequence
@@ -0,0 +1,191 @@
+// fms_sequence_reduce.h - several reductions in a single pass
+#pragma once
+#include <cstddef>
+#include <limits>
+#include <tuple>
+#include "fms_sequence.h"
+
+namespace fms::sequence {
+
+    // accumulators having add(x) and value()
+    namespace reducer {
+
+        template<class T = double>
+        class sum {
+            T s;
+        public:
+            sum(T s = 0) noexcept
+                : s(s)
+            { }
+            void add(const T& x)
+            {
+                s += x;
+            }
+            T value() const
+            {
+                return s;
+            }
+        };
+
+        template<class T = double>
+        class product {
+            T p;
+        public:
+            product(T p = 1) noexcept
+                : p(p)
+            { }
+            void add(const T& x)
+            {
+                p *= x;
+            }
+            T value() const
+            {
+                return p;
+            }
+        };
+
+        class count {
+            size_t n;
+        public:
+            count() noexcept
+                : n(0)
+            { }
+            template<class T>
+            void add(const T&)
+            {
+                ++n;
+            }
+            size_t value() const
+            {
+                return n;
+            }
+        };
+
+        // numeric_limits<T>::max() if no elements
+        template<class T = double>
+        class min {
+            T m;
+        public:
+            min(T m = (std::numeric_limits<T>::max)()) noexcept
+                : m(m)
+            { }
+            void add(const T& x)
+            {
+                m = x < m ? x : m;
+            }
+            T value() const
+            {
+                return m;
+            }
+        };
+
+        // numeric_limits<T>::lowest() if no elements
+        template<class T = double>
+        class max {
+            T m;
+        public:
+            max(T m = std::numeric_limits<T>::lowest()) noexcept
+                : m(m)
+            { }
+            void add(const T& x)
+            {
+                m = m < x ? x : m;
+            }
+            T value() const
+            {
+                return m;
+            }
+        };
+
+        // running mean and variance using Welford's algorithm
+        template<class T = double>
+        class moments {
+        protected:
+            size_t n;
+            T m, m2; // mean and sum of squared deviations from the mean
+        public:
+            moments() noexcept
+                : n(0), m(0), m2(0)
+            { }
+            void add(const T& x)
+            {
+                ++n;
+                T d = x - m;
+                m += d / static_cast<T>(n);
+                m2 += d * (x - m);
+            }
+            size_t count() const
+            {
+                return n;
+            }
+            T mean() const
+            {
+                return m;
+            }
+            // sample variance, divides by n - 1
+            T variance() const
+            {
+                return n > 1 ? m2 / static_cast<T>(n - 1) : 0;
+            }
+            T value() const
+            {
+                return mean();
+            }
+        };
+
+    } // namespace reducer
+
+    // take<S> where S has a batch fill()
+    template<class S>
+    struct is_batchable : std::false_type { };
+    template<class S>
+    struct is_batchable<take<S>> : std::bool_constant<is_fillable_v<S>> { };
+    template<class S>
+    constexpr bool is_batchable_v = is_batchable<S>::value;
+
+    // feed every element of s to each reducer and return them
+    // arrays are walked as raw pointer loops and batchable sequences are generated in blocks
+    template<class S, class... R>
+    inline std::tuple<R...> reduce_many(S s, R... r)
+    {
+        if constexpr (is_contiguous_v<S>) {
+            return reduce_many(array(s), r...);
+        }
+        else {
+            auto add = [&r...](const auto& x) {
+                (r.add(x), ...);
+            };
+
+            if constexpr (is_pointer_array_v<S>) {
+                const auto* t = s.base().data();
+                for (size_t i = 0, n = s.size(); i < n; ++i) {
+                    add(t[i]);
+                }
+            }
+            else if constexpr (is_batchable_v<S>) {
+                // generate blocks with fill() then reduce them
+                using T = typename S::value_type;
+                constexpr size_t B = 256;
+                T t[B];
+                auto g = s.base();
+                for (size_t n = s.size(); n; ) {
+                    size_t m = n < B ? n : B;
+                    g.fill(t, m);
+                    for (size_t i = 0; i < m; ++i) {
+                        add(t[i]);
+                    }
+                    n -= m;
+                }
+            }
+            else {
+                while (s) {
+                    add(*s);
+                    ++s;
+                }
+            }
+
+            return std::tuple<R...>(r...);
+        }
+    }
+
+} // namespace fms::sequence
@@ -0,0 +1,363 @@
+// fms_sequence_rolling.h - moving window and exponentially weighted statistics
+#pragma once
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <functional>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+#include "fms_sequence.h"
+#include "fms_sequence_reduce.h"
+
+namespace fms::sequence {
+
+    // fixed capacity queue, W = 0 for capacity given at run time
+    template<class T, size_t W = 0>
+    class ring {
+        std::conditional_t<W == 0, std::vector<T>, std::array<T, W>> t;
+        size_t head, n;
+    public:
+        explicit ring(size_t w = W)
+            : t{}, head(0), n(0)
+        {
+            if constexpr (W == 0) {
+                t.resize(w);
+            }
+        }
+        size_t capacity() const noexcept
+        {
+            return t.size();
+        }
+        size_t size() const noexcept
+        {
+            return n;
+        }
+        bool empty() const noexcept
+        {
+            return n == 0;
+        }
+        bool full() const noexcept
+        {
+            return n == capacity();
+        }
+        const T& front() const
+        {
+            return t[head];
+        }
+        const T& back() const
+        {
+            return t[wrap(head + n - 1)];
+        }
+        // i-th element from the front
+        const T& operator[](size_t i) const
+        {
+            return t[wrap(head + i)];
+        }
+        void push_back(const T& x)
+        {
+            t[wrap(head + n)] = x;
+            ++n;
+        }
+        void pop_front()
+        {
+            head = wrap(head + 1);
+            --n;
+        }
+        void pop_back()
+        {
+            --n;
+        }
+    private:
+        size_t wrap(size_t i) const noexcept
+        {
+            return i >= capacity() ? i - capacity() : i;
+        }
+    };
+
+    // window operations having state(w) with push(x), pop(x) and value()
+    namespace window {
+
+        // type of averages of T
+        template<class T>
+        using average_t = std::conditional_t<std::is_integral_v<T>, double, T>;
+
+        // Neumaier's compensated sum for floating point T so removing a
+        // large element does not leave the rounding error of adding it
+        struct sum {
+            template<class T, size_t W>
+            class state {
+                T s, c; // s + c is the sum, c collects the rounding errors of s
+            public:
+                typedef T value_type;
+                state(size_t)
+                    : s(0), c(0)
+                { }
+                void push(const T& x)
+                {
+                    add(x);
+                }
+                void pop(const T& x)
+                {
+                    add(-x);
+                }
+                value_type value() const
+                {
+                    return s + c;
+                }
+            private:
+                void add(const T& x)
+                {
+                    if constexpr (std::is_floating_point_v<T>) {
+                        T t = s + x;
+                        c += std::fabs(s) >= std::fabs(x) ? (s - t) + x : (x - t) + s;
+                        s = t;
+                    }
+                    else {
+                        s += x;
+                    }
+                }
+            };
+        };
+
+        // reducer::moments with removal
+        // removal cancels, so the state is stale and rebuilt from the window when m2 goes negative
+        // or falls below 2^-20 of its peak since the last rebuild, and every 64 windows to bound drift
+        struct moments {
+            template<class T, size_t W>
+            class state : public reducer::moments<average_t<T>> {
+                using U = average_t<T>;
+                using base = reducer::moments<U>;
+                size_t pops, w;
+                U peak;
+            public:
+                typedef U value_type;
+                state(size_t w)
+                    : pops(0), w(w), peak(0)
+                { }
+                void push(const T& x)
+                {
+                    base::add(x);
+                    peak = this->m2 > peak ? this->m2 : peak;
+                }
+                void pop(const T& x)
+                {
+                    ++pops;
+                    if (--this->n == 0) {
+                        this->m = this->m2 = 0;
+                    }
+                    else {
+                        U d = x - this->m;
+                        this->m -= d / static_cast<U>(this->n);
+                        this->m2 -= d * (x - this->m);
+                    }
+                }
+                bool stale() const
+                {
+                    return this->m2 < 0 || this->m2 < peak * U(0x1p-20) || pops >= 64 * w;
+                }
+            };
+        };
+
+        struct mean {
+            template<class T, size_t W>
+            struct state : moments::state<T, W> {
+                using moments::state<T, W>::state;
+                auto value() const
+                {
+                    return this->mean();
+                }
+            };
+        };
+
+        struct variance {
+            template<class T, size_t W>
+            struct state : moments::state<T, W> {
+                using moments::state<T, W>::state;
+                auto value() const
+                {
+                    return this->variance();
+                }
+            };
+        };
+
+        // monotonic deque holding the candidates for the extremum in order
+        template<class Less>
+        struct extremum {
+            template<class T, size_t W>
+            class state {
+                ring<T, W> d;
+            public:
+                typedef T value_type;
+                state(size_t w)
+                    : d(w)
+                { }
+                void push(const T& x)
+                {
+                    while (!d.empty() && Less{}(x, d.back())) {
+                        d.pop_back();
+                    }
+                    d.push_back(x);
+                }
+                void pop(const T& x)
+                {
+                    if (!Less{}(d.front(), x) && !Less{}(x, d.front())) {
+                        d.pop_front();
+                    }
+                }
+                value_type value() const
+                {
+                    return d.front();
+                }
+            };
+        };
+        using min = extremum<std::less<>>;
+        using max = extremum<std::greater<>>;
+
+        // states with stale() are rebuilt from the window when it returns true
+        template<class State, class = void>
+        struct has_stale : std::false_type { };
+        template<class State>
+        struct has_stale<State, std::void_t<decltype(std::declval<const State&>().stale())>> : std::true_type { };
+        template<class State>
+        constexpr bool has_stale_v = has_stale<State>::value;
+
+    } // namespace window
+
+    // Op over the last w elements of s, or fewer at the start, in amortized O(1) per element
+    // W > 0 keeps the window in a std::array instead of a std::vector
+    template<class Op, class S, size_t W = 0>
+    class rolling {
+        using T = typename S::value_type;
+        using state = typename Op::template state<T, W>;
+        S s;
+        ring<T, W> x; // current window
+        state op;
+    public:
+        typedef typename state::value_type value_type;
+        rolling(size_t w, S s)
+            : s(s), x(w), op(w)
+        {
+            if (w == 0 || (W != 0 && w != W)) {
+                throw std::invalid_argument("fms::sequence::rolling: window size must be positive and match W");
+            }
+            if (this->s) {
+                push();
+            }
+        }
+        template<size_t W_ = W, class = std::enable_if_t<W_ != 0>>
+        rolling(S s)
+            : rolling(W, s)
+        { }
+        bool operator==(const rolling& s) const
+        {
+            return this->s == s.s && x.capacity() == s.x.capacity();
+        }
+        bool operator!=(const rolling& s) const
+        {
+            return !operator==(s);
+        }
+        operator bool() const
+        {
+            return static_cast<bool>(s);
+        }
+        // one output per input
+        template<class S_ = S, class = std::enable_if_t<is_sized_v<S_>>>
+        size_t size() const noexcept
+        {
+            return s.size();
+        }
+        rolling& operator++()
+        {
+            if (*this) {
+                ++s;
+                if (s) {
+                    push();
+                }
+            }
+
+            return *this;
+        }
+        value_type operator*() const
+        {
+            return op.value();
+        }
+    private:
+        void push()
+        {
+            if (x.full()) {
+                op.pop(x.front());
+                x.pop_front();
+            }
+            T t = *s;
+            x.push_back(t);
+            op.push(t);
+            if constexpr (window::has_stale_v<state>) {
+                if (op.stale()) {
+                    op = state(x.capacity());
+                    for (size_t i = 0; i < x.size(); ++i) {
+                        op.push(x[i]);
+                    }
+                }
+            }
+        }
+    };
+
+    // rolling Op over a window of w elements
+    template<class Op, class S>
+    inline auto roll(size_t w, S s)
+    {
+        return rolling<Op, S>(w, s);
+    }
+    // rolling Op over a window of W elements known at compile time
+    template<class Op, size_t W, class S>
+    inline auto roll(S s)
+    {
+        return rolling<Op, S, W>(s);
+    }
+
+    // m_0 = s_0, m_n = lambda m_{n-1} + (1 - lambda) s_n
+    template<class S, class T = window::average_t<typename S::value_type>>
+    class ewma {
+        S s;
+        T lambda, m;
+    public:
+        typedef T value_type;
+        ewma(T lambda, S s)
+            : s(s), lambda(lambda), m(s ? static_cast<T>(*s) : T(0))
+        { }
+        bool operator==(const ewma& s) const
+        {
+            return lambda == s.lambda && this->s == s.s;
+        }
+        bool operator!=(const ewma& s) const
+        {
+            return !operator==(s);
+        }
+        operator bool() const
+        {
+            return static_cast<bool>(s);
+        }
+        template<class S_ = S, class = std::enable_if_t<is_sized_v<S_>>>
+        size_t size() const noexcept
+        {
+            return s.size();
+        }
+        ewma& operator++()
+        {
+            if (*this) {
+                ++s;
+                if (s) {
+                    m = lambda * m + (1 - lambda) * static_cast<T>(*s);
+                }
+            }
+
+            return *this;
+        }
+        value_type operator*() const
+        {
+            return m;
+        }
+    };
+
+} // namespace fms::sequence
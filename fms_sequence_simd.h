@@ -0,0 +1,355 @@
+// fms_sequence_simd.h - blocked and vectorized scans over contiguous memory
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FMS_SEQUENCE_SSE2 1
+#include <emmintrin.h>
+#endif
+#if defined(__AVX2__)
+#define FMS_SEQUENCE_AVX2 1
+#include <immintrin.h>
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// Aligned loads never cross a page but may read outside the object being scanned.
+#if defined(__clang__) || defined(__GNUC__)
+#define FMS_SEQUENCE_NO_SANITIZE __attribute__((no_sanitize_address))
+#else
+#define FMS_SEQUENCE_NO_SANITIZE
+#endif
+
+namespace fms::sequence::simd {
+
+    // index of lowest set bit of m != 0
+    inline unsigned ctz(unsigned m) noexcept
+    {
+#if defined(_MSC_VER)
+        unsigned long i;
+        _BitScanForward(&i, m);
+
+        return static_cast<unsigned>(i);
+#else
+        return static_cast<unsigned>(__builtin_ctz(m));
+#endif
+    }
+
+    // trailing zero bits of m != 0
+    inline unsigned ctz64(uint64_t m) noexcept
+    {
+#if defined(_MSC_VER) && defined(_M_X64)
+        unsigned long i;
+        _BitScanForward64(&i, m);
+
+        return static_cast<unsigned>(i);
+#elif defined(_MSC_VER)
+        return static_cast<uint32_t>(m) ? ctz(static_cast<uint32_t>(m)) : 32 + ctz(static_cast<uint32_t>(m >> 32));
+#else
+        return static_cast<unsigned>(__builtin_ctzll(m));
+#endif
+    }
+
+    // leading zero bits of m != 0
+    inline unsigned clz64(uint64_t m) noexcept
+    {
+#if defined(_MSC_VER) && defined(_M_X64)
+        unsigned long i;
+        _BitScanReverse64(&i, m);
+
+        return 63 - static_cast<unsigned>(i);
+#elif defined(_MSC_VER)
+        unsigned n = 0;
+        for (uint64_t b = uint64_t(1) << 63; !(m & b); b >>= 1) {
+            ++n;
+        }
+
+        return n;
+#else
+        return static_cast<unsigned>(__builtin_clzll(m));
+#endif
+    }
+
+    // number of elements before the first t[i] == 0
+    template<class T>
+    inline size_t find_zero_scalar(const T* t) noexcept
+    {
+        const T* p = t;
+
+        while (*p != 0) {
+            ++p;
+        }
+
+        return p - t;
+    }
+
+#ifdef FMS_SEQUENCE_SSE2
+    // one bit per byte of each lane in the aligned 16 byte block p that compares equal to zero
+    template<class T>
+    FMS_SEQUENCE_NO_SANITIZE
+    inline unsigned zero_mask_sse2(const char* p) noexcept
+    {
+        if constexpr (std::is_floating_point_v<T>) {
+            if constexpr (sizeof(T) == 4) {
+                auto x = _mm_load_ps(reinterpret_cast<const float*>(p));
+                return _mm_movemask_epi8(_mm_castps_si128(_mm_cmpeq_ps(x, _mm_setzero_ps())));
+            }
+            else {
+                auto x = _mm_load_pd(reinterpret_cast<const double*>(p));
+                return _mm_movemask_epi8(_mm_castpd_si128(_mm_cmpeq_pd(x, _mm_setzero_pd())));
+            }
+        }
+        else {
+            auto x = _mm_load_si128(reinterpret_cast<const __m128i*>(p));
+            if constexpr (sizeof(T) == 1) {
+                return _mm_movemask_epi8(_mm_cmpeq_epi8(x, _mm_setzero_si128()));
+            }
+            else {
+                return _mm_movemask_epi8(_mm_cmpeq_epi32(x, _mm_setzero_si128()));
+            }
+        }
+    }
+
+    // 16 byte blocks like strlen, t must be aligned to sizeof(T)
+    template<class T>
+    inline size_t find_zero_sse2(const T* t) noexcept
+    {
+        using U = std::remove_cv_t<T>;
+        auto u = reinterpret_cast<std::uintptr_t>(t);
+        auto p = reinterpret_cast<const char*>(u & ~std::uintptr_t(15));
+        unsigned skip = static_cast<unsigned>(u & 15); // bytes before t in first block
+
+        unsigned m = zero_mask_sse2<U>(p) & (0xFFFFu << skip);
+        while (!m) {
+            p += 16;
+            m = zero_mask_sse2<U>(p);
+        }
+
+        return (p + ctz(m) - reinterpret_cast<const char*>(t)) / sizeof(T);
+    }
+#endif
+
+    // number of elements before the first t[i] == 0
+    template<class T>
+    inline size_t find_zero(const T* t) noexcept
+    {
+#ifdef FMS_SEQUENCE_SSE2
+        using U = std::remove_cv_t<T>;
+        if constexpr (std::is_same_v<U, char> || std::is_same_v<U, signed char> || std::is_same_v<U, unsigned char>
+            || (std::is_integral_v<U> && sizeof(U) == 4)
+            || std::is_same_v<U, float> || std::is_same_v<U, double>) {
+            if (reinterpret_cast<std::uintptr_t>(t) % sizeof(T) == 0) {
+                return find_zero_sse2(t);
+            }
+        }
+#endif
+        return find_zero_scalar(t);
+    }
+
+    // bits of a double and the double having those bits
+    inline uint64_t bits(double x) noexcept
+    {
+        uint64_t u;
+        std::memcpy(&u, &x, sizeof u);
+
+        return u;
+    }
+    inline double value(uint64_t u) noexcept
+    {
+        double x;
+        std::memcpy(&x, &u, sizeof x);
+
+        return x;
+    }
+
+#ifdef FMS_SEQUENCE_SSE2
+    // packed doubles and their bits for branch free kernels
+    // comparisons return lanes of all ones or all zeros for use with select
+    struct u64x2 {
+        __m128i v;
+
+        u64x2() = default;
+        u64x2(__m128i v) noexcept : v(v) { }
+        u64x2(uint64_t u) noexcept : v(_mm_set1_epi64x(static_cast<long long>(u))) { }
+
+        friend u64x2 operator&(u64x2 a, u64x2 b) noexcept { return _mm_and_si128(a.v, b.v); }
+        friend u64x2 operator|(u64x2 a, u64x2 b) noexcept { return _mm_or_si128(a.v, b.v); }
+        friend u64x2 operator<<(u64x2 a, int n) noexcept { return _mm_slli_epi64(a.v, n); }
+        friend u64x2 operator>>(u64x2 a, int n) noexcept { return _mm_srli_epi64(a.v, n); }
+    };
+    struct f64x2 {
+        static constexpr size_t size = 2;
+        __m128d v;
+
+        f64x2() = default;
+        f64x2(__m128d v) noexcept : v(v) { }
+        f64x2(double x) noexcept : v(_mm_set1_pd(x)) { }
+
+        static f64x2 load(const double* p) noexcept { return _mm_loadu_pd(p); }
+        void store(double* p) const noexcept { _mm_storeu_pd(p, v); }
+
+        friend f64x2 operator+(f64x2 a, f64x2 b) noexcept { return _mm_add_pd(a.v, b.v); }
+        friend f64x2 operator-(f64x2 a, f64x2 b) noexcept { return _mm_sub_pd(a.v, b.v); }
+        friend f64x2 operator*(f64x2 a, f64x2 b) noexcept { return _mm_mul_pd(a.v, b.v); }
+        friend f64x2 operator/(f64x2 a, f64x2 b) noexcept { return _mm_div_pd(a.v, b.v); }
+        friend f64x2 operator<(f64x2 a, f64x2 b) noexcept { return _mm_cmplt_pd(a.v, b.v); }
+        friend f64x2 operator>(f64x2 a, f64x2 b) noexcept { return _mm_cmpgt_pd(a.v, b.v); }
+        friend f64x2 operator<=(f64x2 a, f64x2 b) noexcept { return _mm_cmple_pd(a.v, b.v); }
+        friend f64x2 operator>=(f64x2 a, f64x2 b) noexcept { return _mm_cmpge_pd(a.v, b.v); }
+        friend f64x2 operator==(f64x2 a, f64x2 b) noexcept { return _mm_cmpeq_pd(a.v, b.v); }
+        friend f64x2 operator!=(f64x2 a, f64x2 b) noexcept { return _mm_cmpneq_pd(a.v, b.v); }
+        friend f64x2 operator&(f64x2 a, f64x2 b) noexcept { return _mm_and_pd(a.v, b.v); }
+        friend f64x2 operator|(f64x2 a, f64x2 b) noexcept { return _mm_or_pd(a.v, b.v); }
+
+        // m ? a : b lane by lane
+        friend f64x2 select(f64x2 m, f64x2 a, f64x2 b) noexcept
+        {
+            return _mm_or_pd(_mm_and_pd(m.v, a.v), _mm_andnot_pd(m.v, b.v));
+        }
+        friend f64x2 abs(f64x2 a) noexcept { return _mm_andnot_pd(_mm_set1_pd(-0.), a.v); }
+        // one bit per lane
+        friend unsigned movemask(f64x2 m) noexcept { return static_cast<unsigned>(_mm_movemask_pd(m.v)); }
+        friend bool any(f64x2 m) noexcept { return movemask(m) != 0; }
+    };
+
+    inline u64x2 bits(f64x2 a) noexcept
+    {
+        return _mm_castpd_si128(a.v);
+    }
+    inline f64x2 value(u64x2 u) noexcept
+    {
+        return _mm_castsi128_pd(u.v);
+    }
+#endif
+
+#ifdef FMS_SEQUENCE_AVX2
+    struct u64x4 {
+        __m256i v;
+
+        u64x4() = default;
+        u64x4(__m256i v) noexcept : v(v) { }
+        u64x4(uint64_t u) noexcept : v(_mm256_set1_epi64x(static_cast<long long>(u))) { }
+
+        friend u64x4 operator&(u64x4 a, u64x4 b) noexcept { return _mm256_and_si256(a.v, b.v); }
+        friend u64x4 operator|(u64x4 a, u64x4 b) noexcept { return _mm256_or_si256(a.v, b.v); }
+        friend u64x4 operator<<(u64x4 a, int n) noexcept { return _mm256_slli_epi64(a.v, n); }
+        friend u64x4 operator>>(u64x4 a, int n) noexcept { return _mm256_srli_epi64(a.v, n); }
+    };
+    struct f64x4 {
+        static constexpr size_t size = 4;
+        __m256d v;
+
+        f64x4() = default;
+        f64x4(__m256d v) noexcept : v(v) { }
+        f64x4(double x) noexcept : v(_mm256_set1_pd(x)) { }
+
+        static f64x4 load(const double* p) noexcept { return _mm256_loadu_pd(p); }
+        void store(double* p) const noexcept { _mm256_storeu_pd(p, v); }
+
+        friend f64x4 operator+(f64x4 a, f64x4 b) noexcept { return _mm256_add_pd(a.v, b.v); }
+        friend f64x4 operator-(f64x4 a, f64x4 b) noexcept { return _mm256_sub_pd(a.v, b.v); }
+        friend f64x4 operator*(f64x4 a, f64x4 b) noexcept { return _mm256_mul_pd(a.v, b.v); }
+        friend f64x4 operator/(f64x4 a, f64x4 b) noexcept { return _mm256_div_pd(a.v, b.v); }
+        friend f64x4 operator<(f64x4 a, f64x4 b) noexcept { return _mm256_cmp_pd(a.v, b.v, _CMP_LT_OQ); }
+        friend f64x4 operator>(f64x4 a, f64x4 b) noexcept { return _mm256_cmp_pd(a.v, b.v, _CMP_GT_OQ); }
+        friend f64x4 operator<=(f64x4 a, f64x4 b) noexcept { return _mm256_cmp_pd(a.v, b.v, _CMP_LE_OQ); }
+        friend f64x4 operator>=(f64x4 a, f64x4 b) noexcept { return _mm256_cmp_pd(a.v, b.v, _CMP_GE_OQ); }
+        friend f64x4 operator==(f64x4 a, f64x4 b) noexcept { return _mm256_cmp_pd(a.v, b.v, _CMP_EQ_OQ); }
+        friend f64x4 operator!=(f64x4 a, f64x4 b) noexcept { return _mm256_cmp_pd(a.v, b.v, _CMP_NEQ_UQ); }
+        friend f64x4 operator&(f64x4 a, f64x4 b) noexcept { return _mm256_and_pd(a.v, b.v); }
+        friend f64x4 operator|(f64x4 a, f64x4 b) noexcept { return _mm256_or_pd(a.v, b.v); }
+
+        friend f64x4 select(f64x4 m, f64x4 a, f64x4 b) noexcept { return _mm256_blendv_pd(b.v, a.v, m.v); }
+        friend f64x4 abs(f64x4 a) noexcept { return _mm256_andnot_pd(_mm256_set1_pd(-0.), a.v); }
+        friend unsigned movemask(f64x4 m) noexcept { return static_cast<unsigned>(_mm256_movemask_pd(m.v)); }
+        friend bool any(f64x4 m) noexcept { return movemask(m) != 0; }
+    };
+
+    inline u64x4 bits(f64x4 a) noexcept
+    {
+        return _mm256_castpd_si256(a.v);
+    }
+    inline f64x4 value(u64x4 u) noexcept
+    {
+        return _mm256_castsi256_pd(u.v);
+    }
+#endif
+
+    // widest packed double available, if any
+#if defined(FMS_SEQUENCE_AVX2)
+#define FMS_SEQUENCE_F64 1
+    using f64 = f64x4;
+#elif defined(FMS_SEQUENCE_SSE2)
+#define FMS_SEQUENCE_F64 1
+    using f64 = f64x2;
+#endif
+
+#ifdef FMS_SEQUENCE_SSE2
+    // one bit per lane of the 16 bytes at p with x + 1 == 1
+    inline unsigned negligible_mask_sse2(const float* p) noexcept
+    {
+        auto one = _mm_set1_ps(1);
+
+        return _mm_movemask_ps(_mm_cmpeq_ps(_mm_add_ps(_mm_loadu_ps(p), one), one));
+    }
+    inline unsigned negligible_mask_sse2(const double* p) noexcept
+    {
+        auto one = _mm_set1_pd(1);
+
+        return _mm_movemask_pd(_mm_cmpeq_pd(_mm_add_pd(_mm_loadu_pd(p), one), one));
+    }
+#endif
+
+    // number of leading elements of t[0], ..., t[n-1] with t[i] + 1 != 1
+    // floats and doubles are compared 16 bytes at a time
+    template<class T>
+    inline size_t find_negligible(const T* t, size_t n) noexcept
+    {
+        size_t i = 0;
+
+#ifdef FMS_SEQUENCE_SSE2
+        using U = std::remove_cv_t<T>;
+        if constexpr (std::is_same_v<U, float> || std::is_same_v<U, double>) {
+            constexpr size_t L = 16 / sizeof(U);
+            for (; n - i >= L; i += L) {
+                if (unsigned m = negligible_mask_sse2(t + i)) {
+                    return i + ctz(m);
+                }
+            }
+        }
+#endif
+        while (i < n && t[i] + 1 != 1) {
+            ++i;
+        }
+
+        return i;
+    }
+
+    // number of leading elements of t[0], ..., t[n-1] satisfying p
+    // p is evaluated on whole blocks of B elements before testing, so there
+    // is one exit branch per block instead of one per element
+    template<size_t B = 16, class T, class P>
+    inline size_t find_if_not(const T* t, size_t n, P p)
+    {
+        size_t i = 0;
+
+        for (; i + B <= n; i += B) {
+            bool all = true;
+            for (size_t j = 0; j < B; ++j) {
+                all &= static_cast<bool>(p(t[i + j]));
+            }
+            if (!all) {
+                break;
+            }
+        }
+        while (i < n && p(t[i])) {
+            ++i;
+        }
+
+        return i;
+    }
+
+} // namespace fms::sequence::simd